@@ -0,0 +1,230 @@
+#ifndef DATASET_HPP
+#define DATASET_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+#include "rng.hpp"
+
+namespace bench {
+namespace tools {
+
+/**
+ * Read-only, private memory mapping of a whole file.
+ *
+ * The mapping lives as long as this object, so any views handed out into it
+ * must not outlive it.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    int open(const std::string& path);
+    void close();
+
+    const char* data() const { return addr; }
+    std::size_t size() const { return length; }
+
+private:
+    const char* addr = nullptr;
+    std::size_t length = 0;
+};
+
+/**
+ * Anonymous memory mapping, optionally backed by transparent huge pages.
+ */
+class Arena
+{
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&& other) noexcept;
+    Arena& operator=(Arena&& other) noexcept;
+    ~Arena();
+
+    int allocate(std::size_t size, bool huge_pages);
+    void release();
+
+    char* data() const { return addr; }
+    std::size_t size() const { return length; }
+
+private:
+    char* addr = nullptr;
+    std::size_t length = 0;
+};
+
+/**
+ * Header of binary data sets.
+ *
+ * A binary data set consists of this header followed by num_pairs densely
+ * packed records. Each record holds a key followed by its value without any
+ * delimiters or padding. Integers are stored in host byte order.
+ *
+ * In the fixed-width layout (DATASET_VERSION_FIXED), all keys have key_size
+ * bytes and all values have val_size bytes.
+ *
+ * In the variable-width layout (DATASET_VERSION_VARIABLE), key_size and
+ * val_size are the largest sizes found in the data set. The header is
+ * followed by a table of 2 * num_pairs + 1 offsets relative to the first
+ * record: key i spans [offsets[2i], offsets[2i+1]) and value i spans
+ * [offsets[2i+1], offsets[2i+2]).
+ */
+struct DatasetHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t key_size;
+    std::uint64_t val_size;
+    std::uint64_t num_pairs;
+};
+
+using dataset_header_t = DatasetHeader;
+
+constexpr char DATASET_MAGIC[8] = {'K', 'V', 'D', 'A', 'T', 'A', 0, 0};
+constexpr std::uint32_t DATASET_VERSION_FIXED = 1;
+constexpr std::uint32_t DATASET_VERSION_VARIABLE = 2;
+
+void initDatasetHeader(dataset_header_t& header, std::uint32_t version,
+        std::uint64_t key_size, std::uint64_t val_size, std::uint64_t num_pairs);
+
+using kv_pair_t = std::pair<std::string_view, std::string_view>;
+
+/**
+ * Sample data set of key-value pairs.
+ *
+ * Pairs are never copied out of the data file. Instead, the file is mapped
+ * into memory. For CSV files, an index of views into that mapping is built on
+ * load. For binary files, pairs are located by offset arithmetic or through
+ * the offset table stored in the file.
+ *
+ * A procedural data set has no file at all. It is specified as
+ * proc:NUM_PAIRS:KEY_SIZE:VAL_SIZE[:SEED] and derives pair i from the seed
+ * and i on every access. These are the pairs kv-gen writes for that seed
+ * with fixed key and value sizes and --key-mode random, but not with size
+ * distributions or other key modes. The returned views then refer to a thread-local buffer and are only
+ * valid until the same thread accesses the next pair.
+ *
+ * Any data set can be compacted into an arena afterwards (see
+ * compactDataset). Pairs are then stored as null-terminated keys and values
+ * back to back in one buffer which is preceded by an offset table.
+ */
+class Dataset
+{
+public:
+    std::size_t size() const { return num_pairs; }
+    bool empty() const { return num_pairs == 0; }
+
+    /**
+     * Tells if keys and values are followed by a null character.
+     */
+    bool terminated() const
+    {
+        return layout == layout_t::Arena || layout == layout_t::Procedural;
+    }
+
+    /**
+     * Returns str as a null-terminated string. It is copied into buf only if
+     * this data set does not terminate its strings already.
+     */
+    const char* cstr(std::string_view str, std::string& buf) const
+    {
+        if (terminated())
+            return str.data();
+        buf.assign(str.data(), str.size());
+        return buf.c_str();
+    }
+
+    kv_pair_t operator[](std::size_t pos) const
+    {
+        switch (layout) {
+        case layout_t::Fixed:
+            {
+                const char* record = records + pos * (key_size + val_size);
+                return {{record, key_size}, {record + key_size, val_size}};
+            }
+
+        case layout_t::Variable:
+            {
+                const auto entry = offsets + 2 * pos;
+                return {{records + entry[0], entry[1] - entry[0]},
+                        {records + entry[1], entry[2] - entry[1]}};
+            }
+
+        case layout_t::Arena:
+            {
+                const auto entry = offsets + 2 * pos;
+                return {{records + entry[0], entry[1] - entry[0] - 1},
+                        {records + entry[1], entry[2] - entry[1] - 1}};
+            }
+
+        case layout_t::Procedural:
+            return generate(pos);
+
+        default:
+            return index[pos];
+        }
+    }
+
+private:
+    friend int loadDataset(const std::string& filePath, Dataset& data);
+    friend int compactDataset(Dataset& data, bool huge_pages);
+
+    enum class layout_t { Csv, Fixed, Variable, Arena, Procedural };
+
+    kv_pair_t generate(std::size_t pos) const;
+
+    layout_t layout = layout_t::Csv;
+    MappedFile file;
+
+    // CSV format
+    std::vector<kv_pair_t> index;
+
+    // Arena
+    Arena arena;
+
+    // Binary format and arena
+    const char* records = nullptr;
+    const std::uint64_t* offsets = nullptr;
+    std::size_t key_size = 0;
+    std::size_t val_size = 0;
+
+    // Procedural format
+    CounterRng rng{0};
+
+    std::size_t num_pairs = 0;
+};
+
+using dataset_t = Dataset;
+
+int loadDataset(const std::string& filePath, dataset_t& data);
+
+/**
+ * Determines the number of pairs of a data set without loading it. Binary and
+ * procedural data sets only need their header, CSV files are scanned for
+ * non-empty lines but not indexed.
+ */
+int countPairs(const std::string& filePath, std::size_t& num_pairs);
+
+/**
+ * Copies all pairs of a loaded data set into a single arena and releases the
+ * original storage. If huge_pages is set, the arena is advised to be backed
+ * by transparent huge pages.
+ */
+int compactDataset(dataset_t& data, bool huge_pages);
+
+} // end namespace tools
+} // end namespace bench
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef BENCH_DURATION_HPP
+#define BENCH_DURATION_HPP
+
+#include <string>
+#include <chrono>
+
+namespace bench {
+
+inline double convert_duration(std::chrono::duration<double> dur, const std::string& unit = "")
+{
+    if (unit == "ms")
+        return std::chrono::duration<double, std::milli>{dur}.count();
+
+    if (unit == "us")
+        return std::chrono::duration<double, std::micro>(dur).count();
+
+    if (unit == "ns")
+        return std::chrono::duration<double, std::nano>(dur).count();
+
+    return dur.count();
+}
+
+} // end namespace bench
+
+#endif
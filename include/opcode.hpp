@@ -9,9 +9,15 @@ namespace tools {
 enum class tx_opcode_t
 {
     Get,
-    Put
+    Put,
+    Ins,
+    Del,
+    Rmw
 };
 
+// Highest opcode of a valid command
+constexpr tx_opcode_t TX_OPCODE_MAX = tx_opcode_t::Rmw;
+
 std::ostream& operator<<(std::ostream& os, tx_opcode_t op);
 
 } // end namespace tools
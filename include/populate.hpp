@@ -0,0 +1,146 @@
+#ifndef BENCH_POPULATE_HPP
+#define BENCH_POPULATE_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <cstddef>
+
+#include "duration.hpp"
+#include "dataset.hpp"
+
+namespace bench {
+
+// Number of times a batch is written before it is given up
+const std::size_t POPULATE_ATTEMPTS_MAX = 8;
+
+struct PopulateResult {
+    std::size_t num_pairs = 0;
+    std::size_t num_bytes = 0;
+    std::size_t num_failures = 0;
+    std::size_t num_canceled_batches = 0;
+    std::vector<double> batch_latencies; // seconds, one per commit attempt
+    std::chrono::duration<double> duration{0};
+};
+
+/**
+ * Writes the first num_pairs pairs of a data set into a store.
+ *
+ * Pairs are split into one contiguous range per thread and every range into
+ * transactions of batch_size pairs (0 = the whole range in one transaction).
+ * make_writer is called once on each thread and returns a callable which
+ * writes pairs [first, last) in a single transaction and tells if it has
+ * been committed. Failed batches are written again up to
+ * POPULATE_ATTEMPTS_MAX times.
+ */
+template <typename MakeWriter>
+PopulateResult populate(const tools::dataset_t& pairs, std::size_t num_pairs,
+        std::size_t num_threads, std::size_t batch_size, MakeWriter make_writer)
+{
+    PopulateResult result;
+    num_pairs = std::min(num_pairs, pairs.size());
+    if (!num_pairs)
+        return result;
+
+    num_threads = std::max<std::size_t>(1, std::min(num_threads, num_pairs));
+    std::vector<PopulateResult> results(num_threads);
+
+    const auto time_start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            auto& thread_result = results[t];
+            auto write_batch = make_writer();
+
+            const auto first = num_pairs * t / num_threads;
+            const auto last = num_pairs * (t + 1) / num_threads;
+            const auto batch = batch_size ? batch_size : last - first;
+
+            for (auto batch_first = first; batch_first < last; batch_first += batch) {
+                const auto batch_last = std::min(batch_first + batch, last);
+
+                bool committed = false;
+                for (std::size_t attempt = 0; !committed && attempt < POPULATE_ATTEMPTS_MAX; ++attempt) {
+                    const auto batch_start = std::chrono::high_resolution_clock::now();
+                    committed = write_batch(batch_first, batch_last);
+                    const auto batch_end = std::chrono::high_resolution_clock::now();
+
+                    thread_result.batch_latencies.push_back(
+                        std::chrono::duration<double>{batch_end - batch_start}.count());
+                    if (!committed)
+                        ++thread_result.num_failures;
+                }
+
+                if (!committed) {
+                    ++thread_result.num_canceled_batches;
+                    continue;
+                }
+                for (auto i = batch_first; i < batch_last; ++i) {
+                    const auto [key, val] = pairs[i];
+                    thread_result.num_bytes += key.size() + val.size();
+                }
+                thread_result.num_pairs += batch_last - batch_first;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    result.duration = std::chrono::high_resolution_clock::now() - time_start;
+    for (auto& thread_result : results) {
+        result.num_pairs += thread_result.num_pairs;
+        result.num_bytes += thread_result.num_bytes;
+        result.num_failures += thread_result.num_failures;
+        result.num_canceled_batches += thread_result.num_canceled_batches;
+        result.batch_latencies.insert(result.batch_latencies.end(),
+            thread_result.batch_latencies.begin(), thread_result.batch_latencies.end());
+    }
+    return result;
+}
+
+/**
+ * Writes all pairs of a data set into a store.
+ */
+template <typename MakeWriter>
+PopulateResult populate(const tools::dataset_t& pairs, std::size_t num_threads,
+        std::size_t batch_size, MakeWriter make_writer)
+{
+    return populate(pairs, pairs.size(), num_threads, batch_size, make_writer);
+}
+
+inline void print_populate_result(PopulateResult& result, const std::string& unit)
+{
+    const auto duration = convert_duration(result.duration, unit);
+    std::cout << "populate time=" << duration << ' ' << unit << std::endl;
+    std::cout << "populate pairs=" << result.num_pairs << std::endl;
+    std::cout << "populate failures=" << result.num_failures << std::endl;
+    std::cout << "populate canceled batches=" << result.num_canceled_batches << std::endl;
+    std::cout << "populate throughput=" << (result.num_pairs / duration) << "/" << unit << std::endl;
+    std::cout << "populate bandwidth=" << (result.num_bytes / 1e6 / duration) << "MB/" << unit << std::endl;
+
+    auto& latencies = result.batch_latencies;
+    if (latencies.empty())
+        return;
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto to_unit = [&unit](double seconds) {
+        return convert_duration(std::chrono::duration<double>{seconds}, unit);
+    };
+    const auto sum = std::accumulate(latencies.begin(), latencies.end(), 0.0);
+    std::cout << "populate batches=" << latencies.size() << std::endl;
+    std::cout << "populate batch latency min=" << to_unit(latencies.front())
+        << " avg=" << to_unit(sum / latencies.size())
+        << " med=" << to_unit(latencies[latencies.size() / 2])
+        << " p99=" << to_unit(latencies[latencies.size() * 99 / 100])
+        << " max=" << to_unit(latencies.back())
+        << ' ' << unit << std::endl;
+}
+
+} // end namespace bench
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bench {
+namespace tools {
+
+constexpr std::uint64_t RNG_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+/**
+ * Finalizer of SplitMix64.
+ *
+ * This is a bijection on 64-bit integers which scatters consecutive inputs
+ * across the whole range.
+ */
+inline std::uint64_t mix64(std::uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Counter-based random number generator.
+ *
+ * The i-th output of a stream only depends on its seed and on i. Any part of
+ * a stream can therefore be produced independently of all others, e.g. by
+ * several threads at once, without changing the result. Outputs do not depend
+ * on each other, so filling a buffer is a loop the compiler can vectorize.
+ */
+class CounterRng
+{
+public:
+    explicit CounterRng(std::uint64_t seed) : key{mix64(seed)} {}
+
+    std::uint64_t operator()(std::uint64_t ctr) const
+    {
+        return mix64(key + ctr * RNG_GAMMA);
+    }
+
+    void fill(std::uint64_t ctr, std::uint64_t* out, std::size_t n) const
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = mix64(key + (ctr + i) * RNG_GAMMA);
+    }
+
+private:
+    std::uint64_t key;
+};
+
+/**
+ * Maps a random 64-bit integer onto [0, n) by taking the upper half of their
+ * 128-bit product. This is faster than taking the remainder and, for n far
+ * below 2^64, just as uniform.
+ */
+inline std::uint64_t uniformBelow(std::uint64_t x, std::uint64_t n)
+{
+    return static_cast<std::uint64_t>((static_cast<unsigned __int128>(x) * n) >> 64);
+}
+
+/**
+ * Pseudo-random permutation of [0, size).
+ *
+ * This is a balanced Feistel network on the smallest even number of bits
+ * covering size. Outputs beyond size are fed through the network again
+ * (cycle walking), which takes fewer than four passes on average. Like with
+ * CounterRng, each element of the permutation can be computed on its own.
+ */
+class Permutation
+{
+public:
+    Permutation(std::uint64_t size, std::uint64_t seed) : size{size}
+    {
+        unsigned bits = 2;
+        while (bits < 64 && (1ULL << bits) < size)
+            bits += 2;
+        half = bits / 2;
+        mask = (1ULL << half) - 1;
+
+        const CounterRng rng{seed};
+        for (std::size_t r = 0; r < NUM_ROUNDS; ++r)
+            keys[r] = rng(r);
+    }
+
+    std::uint64_t operator()(std::uint64_t x) const
+    {
+        do {
+            x = encrypt(x);
+        } while (x >= size);
+        return x;
+    }
+
+private:
+    static constexpr std::size_t NUM_ROUNDS = 4;
+
+    std::uint64_t encrypt(std::uint64_t x) const
+    {
+        auto left = x >> half;
+        auto right = x & mask;
+        for (const auto key : keys) {
+            const auto next = left ^ (mix64(right ^ key) & mask);
+            left = right;
+            right = next;
+        }
+        return (left << half) | right;
+    }
+
+    std::uint64_t size;
+    unsigned half;
+    std::uint64_t mask;
+    std::uint64_t keys[NUM_ROUNDS];
+};
+
+/**
+ * Maps a random byte onto [a-z0-9].
+ *
+ * This is branch-free so that converting a whole buffer vectorizes. The
+ * mapping is slightly biased since 256 is not a multiple of 36.
+ */
+inline char toAlnum(unsigned char byte)
+{
+    const unsigned v = (byte * 36u) >> 8;
+    return v < 26 ? 'a' + v : '0' + (v - 26);
+}
+
+/**
+ * Fills dst with n random characters from [a-z0-9], drawing from counters
+ * ctr, ctr + 1, ... of the given stream (one counter per 8 characters).
+ */
+inline void fillAlnum(const CounterRng& rng, std::uint64_t ctr, char* dst,
+        std::size_t n, std::vector<std::uint64_t>& words)
+{
+    const auto num_words = (n + 7) / 8;
+    words.resize(num_words);
+    rng.fill(ctr, words.data(), num_words);
+    const auto bytes = reinterpret_cast<const unsigned char*>(words.data());
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] = toAlnum(bytes[i]);
+}
+
+/**
+ * Generates the contents of pair pos of the data set with the given seed.
+ *
+ * This is shared by kv-gen and procedural data sets, so both produce the
+ * same pairs for the same seed as long as kv-gen writes fixed key and value
+ * sizes in --key-mode random. Size distributions and the other key modes
+ * change the pairs kv-gen writes.
+ */
+inline void generatePair(const CounterRng& rng, std::uint64_t pos,
+        char* key, std::size_t key_size, char* val, std::size_t val_size,
+        std::vector<std::uint64_t>& words)
+{
+    const CounterRng pair_rng{rng(pos)};
+    fillAlnum(pair_rng, 0, key, key_size, words);
+    fillAlnum(pair_rng, (key_size + 7) / 8, val, val_size, words);
+}
+
+} // end namespace tools
+} // end namespace bench
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef TX_GEN_HPP
+#define TX_GEN_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "rng.hpp"
+#include "tx-profile.hpp"
+#include "workload.hpp"
+
+namespace bench {
+namespace tools {
+
+// Length range of transactions whose profile does not set one
+constexpr std::size_t TX_LENGTH_MIN_DEFAULT = 2;
+constexpr std::size_t TX_LENGTH_MAX_DEFAULT = 64;
+
+/**
+ * Draws positions in [0, n) from a key distribution, where n starts at
+ * num_pairs and grows as pairs are inserted.
+ *
+ * Each position is derived from a random stream of its own. Zipf sampling
+ * uses rejection-inversion (Hoermann and Derflinger), which takes a few
+ * outputs of that stream at most and needs no table of n entries. Zipf ranks
+ * within the first num_pairs positions are scattered, inserted pairs keep
+ * their rank.
+ */
+class KeySampler
+{
+public:
+    void init(const key_distribution_t& dist, std::uint64_t num_pairs, std::uint64_t seed);
+
+    std::uint64_t operator()(const CounterRng& rng, std::uint64_t n) const;
+
+private:
+    std::uint64_t zipfRank(const CounterRng& rng, std::uint64_t n) const;
+    double h(double x) const;
+    double hIntegral(double x) const;
+    double hIntegralInverse(double x) const;
+
+    key_distribution_t dist;
+    std::uint64_t num_pairs = 1;
+    std::uint64_t num_hot = 1;
+    Permutation scramble{1, 0};
+
+    // Constants of rejection-inversion
+    double h_integral_x1 = 0;
+    double h_integral_n = 0;
+    double s = 0;
+};
+
+/**
+ * Draws transaction lengths in [length_min, length_max] from a length
+ * distribution, or from the buckets of a histogram.
+ *
+ * Each length is derived from a single random number. Normal lengths and
+ * histograms use it to seed a random stream, normal lengths outside the
+ * range being drawn again a few times and then clamped. Geometric lengths
+ * are drawn from the truncated distribution by inversion.
+ */
+class LengthSampler
+{
+public:
+    void init(const length_distribution_t& dist, std::size_t length_min, std::size_t length_max);
+
+    std::size_t operator()(std::uint64_t rand) const;
+
+    /**
+     * Returns the mean length, e.g. to reserve space for the commands of
+     * transactions.
+     */
+    double mean() const;
+
+private:
+    length_distribution_t dist;
+    std::size_t length_min = 1;
+    std::size_t length_max = 1;
+    double log_q = 0;                // log of the failure probability of geometric lengths
+    double tail = 1;                 // probability of a geometric length not to exceed length_max
+    std::vector<double> cumulative;  // cumulative weights of histogram buckets
+};
+
+/**
+ * Number of pairs inserted and deleted by a sequence of transactions.
+ */
+struct TxCursor
+{
+    std::uint64_t num_inserts = 0;
+    std::uint64_t num_deletes = 0;
+
+    TxCursor& operator+=(const TxCursor& other)
+    {
+        num_inserts += other.num_inserts;
+        num_deletes += other.num_deletes;
+        return *this;
+    }
+};
+
+using tx_cursor_t = TxCursor;
+
+inline tx_cursor_t operator+(tx_cursor_t lhs, const tx_cursor_t& rhs)
+{
+    return lhs += rhs;
+}
+
+/**
+ * Generates transactions from transaction profiles.
+ *
+ * Each transaction picks a profile of its phase, a length and then an
+ * operation and a pair for every step. Lengths are drawn from the length
+ * distribution of the profile, within the length range of the profile or
+ * [TX_LENGTH_MIN_DEFAULT, TX_LENGTH_MAX_DEFAULT] if it has none. An
+ * explicit length_min or length_max passed to init overrides that bound of
+ * every profile. Pairs are drawn from the key
+ * distribution of the profile. Phases follow each other
+ * in the order of the schedule, the last one has no end unless all phases
+ * have a number of transactions.
+ *
+ * Only the first num_loaded pairs are expected in the store when the
+ * workload starts. Inserts write the following pairs in order and deletes
+ * remove the oldest pair still there, so after num_inserts inserts and
+ * num_deletes deletes the live pairs are [num_deletes, num_loaded +
+ * num_inserts). All other operations draw a pair up to the last live one
+ * and draw again while it is deleted, so deletes do not move the popular
+ * pairs. After a few draws they take a live pair at random. They are left
+ * out while there are no live pairs.
+ *
+ * Pairs can be partitioned among the workers running the transactions, with
+ * pair k belonging to partition k % num_partitions. The home partition of a
+ * transaction is the worker the scaling drivers give it to (see partBegin),
+ * and each operation targets another partition with probability cross_prob
+ * only. Inserts and deletes change the data set regardless of partitions.
+ *
+ * Transaction i is derived from the seed, i and the number of inserts and
+ * deletes of the transactions before i alone, so any range of transactions
+ * can be generated on its own, e.g. by several threads at once, and the
+ * result is the same. countKeyChanges tells where each range starts.
+ */
+class TxGenerator
+{
+public:
+    /**
+     * num_loaded = 0 means all pairs are loaded, so profiles with inserts
+     * need a smaller num_loaded. length_min and length_max override the
+     * bounds of all profiles unless they are 0.
+     */
+    int init(const tx_phases_t& phases, std::size_t num_pairs,
+            std::size_t length_min, std::size_t length_max, std::uint64_t seed,
+            std::size_t num_loaded = 0);
+
+    /**
+     * Partitions the pairs among num_partitions workers running num_txs
+     * transactions, unless the schedule sets their number. Must be called
+     * after init.
+     */
+    int partition(std::size_t num_partitions, double cross_prob, std::uint64_t num_txs);
+
+    /**
+     * Appends the commands of transaction i to cmds. cursor holds the
+     * inserts and deletes of the transactions before i and is advanced past
+     * those of i.
+     */
+    void generate(std::uint64_t i, std::vector<workload_cmd_t>& cmds, tx_cursor_t& cursor) const;
+
+    /**
+     * Appends transactions [first, last) to workload.
+     */
+    void generate(std::uint64_t first, std::uint64_t last, workload_t& workload,
+            tx_cursor_t cursor) const;
+
+    /**
+     * Returns the inserts and deletes of transactions [first, last) without
+     * generating them, or none right away if no profile inserts or deletes.
+     */
+    tx_cursor_t countKeyChanges(std::uint64_t first, std::uint64_t last) const;
+
+    /**
+     * Checks that the inserts and deletes of a workload fit into num_pairs
+     * pairs: inserts must not run out of pairs, and deletes must leave at
+     * least one of the loaded pairs so that they always hit a live one.
+     */
+    int checkKeyChanges(const tx_cursor_t& total, std::size_t num_pairs) const;
+
+    std::size_t numLoaded() const { return num_loaded; }
+
+    /**
+     * Returns the mean length of the transactions of the first phase.
+     */
+    double meanLength() const;
+
+    /**
+     * Returns the first transaction of each phase.
+     */
+    const std::vector<std::uint64_t>& phaseStarts() const { return phase_starts; }
+
+    /**
+     * Returns the number of transactions of all phases, or 0 if the last
+     * phase has no end.
+     */
+    std::uint64_t scheduleSize() const { return schedule_size; }
+
+private:
+    struct Phase
+    {
+        tx_profiles_t profiles;
+        std::vector<KeySampler> samplers; // one per profile and partition
+        std::vector<LengthSampler> lengths; // one per profile
+    };
+
+    void initSamplers();
+    std::size_t phaseIndex(std::uint64_t i) const;
+    const Phase& phaseOf(std::uint64_t i) const { return phases[phaseIndex(i)]; }
+    std::size_t homePartition(std::uint64_t i) const;
+    std::uint64_t partitionSize(std::uint64_t num_live, std::size_t partition) const;
+    std::size_t selectProfile(const tx_profiles_t& profiles, std::uint64_t rand) const;
+    profile_op_t selectOperation(const tx_profile_t& prof, std::uint64_t rand) const;
+
+    std::vector<Phase> phases;
+    std::vector<std::uint64_t> phase_starts;
+    std::uint64_t schedule_size = 0;
+    std::size_t num_pairs = 0;
+    std::size_t num_loaded = 0;
+    bool key_changes = false; // some profile inserts or deletes
+    std::uint64_t scramble_seed = 0;
+    std::size_t num_partitions = 1;
+    double cross_prob = 0;
+    std::uint64_t partition_txs = 0; // transactions split among partitions
+    CounterRng rng{0};
+};
+
+using tx_generator_t = TxGenerator;
+
+} // end namespace tools
+} // end namespace bench
+
+#endif
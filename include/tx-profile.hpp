@@ -4,28 +4,117 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <ostream>
 
 #include "opcode.hpp"
 
 namespace bench {
 namespace tools {
 
+enum class key_dist_t { Uniform, Zipf, Hotspot, Latest };
+
+/**
+ * Distribution of the pairs a transaction profile accesses.
+ *
+ * Zipf ranks pairs by popularity with exponent theta and scatters the ranks
+ * across the data set. Hotspot sends a fraction hot_ops of all operations to
+ * the first fraction hot_keys of the pairs and the rest to the others.
+ * Latest is Zipf with the most recent pair, i.e. the one at the highest
+ * position, being the most popular.
+ */
+struct KeyDistribution {
+    key_dist_t type = key_dist_t::Uniform;
+    double theta = 0.99;
+    double hot_keys = 0.2;
+    double hot_ops = 0.8;
+};
+
+using key_distribution_t = KeyDistribution;
+
+enum class length_dist_t { Uniform, Normal, Geometric, Histogram };
+
+/**
+ * Bucket of a length histogram: lengths [min, max], drawn uniformly, get a
+ * share of weight of all transactions.
+ */
+struct LengthBucket {
+    std::size_t min = 0;
+    std::size_t max = 0;
+    double weight = 0;
+};
+
+/**
+ * Distribution of the number of operations of a transaction.
+ *
+ * Uniform, normal and geometric lengths lie in [length_min, length_max] of
+ * the profile. Normal lengths have the given mean and stddev. Geometric
+ * lengths are length_min plus the number of failures before a success, with
+ * the given mean before truncation, so that short transactions are the most
+ * frequent. Histogram lengths are drawn from the buckets, e.g. those of a
+ * measured workload, regardless of length_min and length_max.
+ */
+struct LengthDistribution {
+    length_dist_t type = length_dist_t::Uniform;
+    double mean = 0;
+    double stddev = 0;
+    std::vector<LengthBucket> buckets;
+};
+
+using length_distribution_t = LengthDistribution;
+
+/**
+ * Operation of a transaction profile. Get and Put access one pair. A
+ * read-modify-write reads a pair and writes it back. A scan reads up to
+ * scan_length_max pairs at consecutive positions. An insert writes a pair
+ * which has not been accessed before, a delete removes a pair.
+ */
+enum class profile_op_t { Get, Put, ReadModifyWrite, Scan, Insert, Delete };
+
+std::ostream& operator<<(std::ostream& os, profile_op_t op);
+
+// Maximum number of pairs a scan reads unless a profile sets it
+constexpr std::size_t SCAN_LENGTH_MAX = 100;
+
 struct TransactionProfile {
-    using OpProb = std::pair<tx_opcode_t, double>;
+    using OpProb = std::pair<profile_op_t, double>;
 
     double prob;
     std::string name;
     std::vector<OpProb> ops;
-    std::size_t length_min = 0;
-    std::size_t length_max = 0;
+    std::size_t length_min = 0; // 0 = the generator's default
+    std::size_t length_max = 0; // 0 = the generator's default
+    LengthDistribution lengths;
+    std::size_t scan_length_max = SCAN_LENGTH_MAX;
+    KeyDistribution keys;
 };
 
 using tx_profile_t = TransactionProfile;
 using tx_profiles_t = std::vector<tx_profile_t>;
 
+/**
+ * Phase of a workload, i.e. num_txs transactions generated from profiles.
+ */
+struct TransactionPhase {
+    std::size_t num_txs = 0;
+    tx_profiles_t profiles;
+};
+
+using tx_phase_t = TransactionPhase;
+using tx_phases_t = std::vector<tx_phase_t>;
+
 int parseTransactionProfiles(const std::string& filePath,
         tx_profiles_t& profiles);
 
+/**
+ * Reads a schedule of phases. A file with a "phases" array holds one object
+ * per phase with its number of transactions in "txs" and its profiles in
+ * "profiles", either inline or as the path of a profile file relative to the
+ * schedule. Any other file holds profiles, which make up a single phase with
+ * num_txs = 0.
+ */
+int parseTransactionPhases(const std::string& filePath,
+        tx_phases_t& phases);
+
 } // end namespace tools
 } // end namespace bench
 
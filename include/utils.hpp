@@ -4,65 +4,41 @@
 #include <string>
 #include <vector>
 #include <chrono>
-#include <fstream>
 #include <cstddef>
+#include <cstdint>
+#include <random>
 #include <stdexcept>
 
 #include <getopt.h> // getopt_long
 
-namespace bench {
+#include "duration.hpp"
 
-using KVPair = std::pair<std::string, std::string>;
+namespace bench {
 
 struct ProgramArgs {
     std::string data_file;
     std::string workload_file;
+    std::string tx_profile_file;
+    std::size_t num_txs = 1000;
+    std::size_t tx_length_min = 0; // 0 = length_min of each profile
+    std::size_t tx_length_max = 0; // 0 = length_max of each profile
+    std::size_t num_loaded = 0;
+    bool partitioned = false;
+    double cross_prob = 0;
+    std::uint64_t seed = std::random_device{}();
     std::size_t cpu_offset = 0;
     std::size_t smt_ratio = 2;
     std::size_t num_threads = 1;
     std::size_t num_retries = 0;
+    std::size_t populate_threads = 1;
+    std::size_t populate_batch = 0;
     std::string unit = "s";
+    bool arena = false;
+    bool huge_pages = false;
+    bool stream = false;
     bool verbose = false;
 };
 
-int read_pairs(const std::string& path, std::vector<KVPair>& pairs)
-{
-    std::ifstream ifstream{path};
-    if (!ifstream.is_open())
-        return 1;
-
-    std::string line;
-    while (std::getline(ifstream, line)) {
-        if (!line.empty()) {
-            const auto pos_delim = line.find(';');
-            if (pos_delim != std::string::npos) {
-                pairs.emplace_back(
-                    line.substr(0, pos_delim), // get chars before delimiter
-                    line.substr(pos_delim + 1) // get chars after delimiter
-                );
-            }
-            else {
-                throw std::invalid_argument("error: missing delimiter (;) in line");
-            }
-        }
-    }
-    return 0;
-}
-
-double convert_duration(std::chrono::duration<double> dur, const std::string& unit = "")
-{
-    if (unit == "ms")
-        return std::chrono::duration<double, std::milli>{dur}.count();
-
-    if (unit == "us")
-        return std::chrono::duration<double, std::micro>(dur).count();
-
-    if (unit == "ns")
-        return std::chrono::duration<double, std::nano>(dur).count();
-
-    return dur.count();
-}
-
 void usage()
 {
     ProgramArgs pargs;
@@ -73,9 +49,36 @@ void usage()
     std::cout << "\nDESCRIPTION\n";
     std::cout << "\nOPTIONS\n";
     std::cout << "\t-d, --data FILE\n";
-    std::cout << "\t\tPath to a file containing sample data pairs in CSV format. This parameter is required.\n";
+    std::cout << "\t\tPath to a file containing sample data pairs in CSV or binary format. This parameter is required.\n";
+    std::cout << "\t\tAlternatively, proc:NUM_PAIRS:KEY_SIZE:VAL_SIZE[:SEED] derives pairs on the fly without a file.\n";
     std::cout << "\n\t-w, --workload FILE\n";
     std::cout << "\t\tPath to a file containing the workload to be executed.\n";
+    std::cout << "\n\t-x, --tx-profile FILE\n";
+    std::cout << "\t\tPath to a file containing transaction profiles. Instead of running a workload file, each worker\n";
+    std::cout << "\t\tgenerates its transactions from the profiles in the background while running the previous ones.\n";
+    std::cout << "\n\t-n, --num-txs INT\n";
+    std::cout << "\t\tThe number of transactions generated with --tx-profile. (default = " << pargs.num_txs << ")\n";
+    std::cout << "\n\t-i, --tx-length-min INT\n";
+    std::cout << "\t\tThe minimum number of operations of a generated transaction. Overrides length_min of all\n";
+    std::cout << "\t\tprofiles. (default = length_min of the profile, or 2)\n";
+    std::cout << "\n\t-l, --tx-length-max INT\n";
+    std::cout << "\t\tThe maximum number of operations of a generated transaction. Overrides length_max of all\n";
+    std::cout << "\t\tprofiles. (default = length_max of the profile, or 64)\n";
+    std::cout << "\n\t-k, --num-loaded INT\n";
+    std::cout << "\t\tThe number of pairs written into the store before the benchmark, i.e. the first INT pairs of the\n";
+    std::cout << "\t\tdata set. Inserts of generated transactions write the following pairs,\n";
+    std::cout << "\t\tdeletes remove the oldest ones. (default = all)\n";
+    std::cout << "\n\t-P, --partitioned\n";
+    std::cout << "\t\tGive each worker a partition of the pairs which its generated transactions access.\n";
+    std::cout << "\n\t-c, --cross-partition-prob FLOAT\n";
+    std::cout << "\t\tWith --partitioned, the probability that an operation accesses another partition than the one of\n";
+    std::cout << "\t\tits worker. (default = " << pargs.cross_prob << ")\n";
+    std::cout << "\n\t-e, --seed INT\n";
+    std::cout << "\t\tSeed of the generated transactions. They only depend on the seed, not on the number of threads.\n";
+    std::cout << "\t\t(default = random)\n";
+    std::cout << "\n\t-s, --stream\n";
+    std::cout << "\t\tRead the workload while running it instead of loading it up front. Each worker reads its part of\n";
+    std::cout << "\t\tthe workload in blocks of bounded size in the background. Requires a binary workload.\n";
     std::cout << "\n\t-t, --num-threads INT\n";
     std::cout << "\t\tThe number of worker threads to spawn. (default = " << pargs.num_threads << ")\n";
     std::cout << "\n\t-o, --cpu-offset INT\n";
@@ -85,6 +88,15 @@ void usage()
     std::cout << "\t\tThe number of hardware threads per CPU. (default = " << pargs.smt_ratio << ")\n";
     std::cout << "\n\t-r, --num-retries INT\n";
     std::cout << "\t\tThe number of times a transaction is restarted if it fails to commit. (default = " << pargs.num_retries << ")\n";
+    std::cout << "\n\t-p, --populate-threads INT\n";
+    std::cout << "\t\tThe number of threads writing the sample data into the store before the benchmark. (default = " << pargs.populate_threads << ")\n";
+    std::cout << "\n\t-b, --populate-batch INT\n";
+    std::cout << "\t\tThe number of pairs written per transaction while populating the store.\n";
+    std::cout << "\t\t0 writes all pairs of a thread in a single transaction. (default = " << pargs.populate_batch << ")\n";
+    std::cout << "\n\t-a, --arena\n";
+    std::cout << "\t\tCopy the sample data into a contiguous arena before running the benchmark.\n";
+    std::cout << "\n\t-g, --huge-pages\n";
+    std::cout << "\t\tLike --arena but back the arena with transparent huge pages.\n";
     std::cout << "\n\t-u, --unit UNIT\n";
     std::cout << "\t\tSets the time unit of used when printing results. Can be one of {s | ms | us | ns} (default = " << pargs.unit << ")\n";
     std::cout << "\n\t-v, --verbose\n";
@@ -96,21 +108,34 @@ void usage()
 void parse_args(int argc, char* argv[], ProgramArgs& args)
 {
     static struct option longopts[] = {
-        { "data"          , required_argument , NULL , 'd' },
-        { "workload"      , required_argument , NULL , 'w' },
-        { "num-threads"   , required_argument , NULL , 't' },
-        { "cpu-offset"    , required_argument , NULL , 'o' },
-        { "smt-ratio"     , required_argument , NULL , 'm' },
-        { "num-retries"   , required_argument , NULL , 'r' },
-        { "unit"          , required_argument , NULL , 'u' },
-        { "verbose"       , no_argument       , NULL , 'v' },
-        { "help"          , no_argument       , NULL , 'h' },
-        { NULL            , 0                 , NULL , 0 }
+        { "data"              , required_argument , NULL , 'd' },
+        { "workload"          , required_argument , NULL , 'w' },
+        { "tx-profile"        , required_argument , NULL , 'x' },
+        { "num-txs"           , required_argument , NULL , 'n' },
+        { "tx-length-min"     , required_argument , NULL , 'i' },
+        { "tx-length-max"     , required_argument , NULL , 'l' },
+        { "seed"              , required_argument , NULL , 'e' },
+        { "num-loaded"        , required_argument , NULL , 'k' },
+        { "partitioned"       , no_argument       , NULL , 'P' },
+        { "cross-partition-prob", required_argument , NULL , 'c' },
+        { "num-threads"       , required_argument , NULL , 't' },
+        { "cpu-offset"        , required_argument , NULL , 'o' },
+        { "smt-ratio"         , required_argument , NULL , 'm' },
+        { "num-retries"       , required_argument , NULL , 'r' },
+        { "unit"              , required_argument , NULL , 'u' },
+        { "populate-threads"  , required_argument , NULL , 'p' },
+        { "populate-batch"    , required_argument , NULL , 'b' },
+        { "arena"             , no_argument       , NULL , 'a' },
+        { "huge-pages"        , no_argument       , NULL , 'g' },
+        { "stream"            , no_argument       , NULL , 's' },
+        { "verbose"           , no_argument       , NULL , 'v' },
+        { "help"              , no_argument       , NULL , 'h' },
+        { NULL                , 0                 , NULL , 0 }
     };
 
     char ch;
     // while ((ch = getopt_long(argc, argv, "d:t:n:r:m:o:i:a:u:h", longopts, NULL)) != -1) {
-    while ((ch = getopt_long(argc, argv, "d:t:o:m:r:w:u:hv", longopts, NULL)) != -1) {
+    while ((ch = getopt_long(argc, argv, "d:t:o:m:r:w:x:n:i:l:e:k:Pc:u:p:b:agshv", longopts, NULL)) != -1) {
         switch (ch) {
         case 'd': // path to data set
             args.data_file = optarg;
@@ -120,6 +145,38 @@ void parse_args(int argc, char* argv[], ProgramArgs& args)
             args.workload_file = optarg;
             break;
 
+        case 'x': // path to transaction profiles
+            args.tx_profile_file = optarg;
+            break;
+
+        case 'n': // number of generated transactions
+            args.num_txs = std::stoull(optarg);
+            break;
+
+        case 'i': // minimum number of operations in a generated transaction
+            args.tx_length_min = std::stoull(optarg);
+            break;
+
+        case 'l': // maximum number of operations in a generated transaction
+            args.tx_length_max = std::stoull(optarg);
+            break;
+
+        case 'e': // seed of generated transactions
+            args.seed = std::stoull(optarg);
+            break;
+
+        case 'k': // number of pairs in the store before the benchmark
+            args.num_loaded = std::stoull(optarg);
+            break;
+
+        case 'P': // one key partition per worker
+            args.partitioned = true;
+            break;
+
+        case 'c': // probability of an operation leaving its partition
+            args.cross_prob = std::stod(optarg);
+            break;
+
         case 't': // number of threads
             args.num_threads = std::stoull(optarg);
             break;
@@ -136,10 +193,31 @@ void parse_args(int argc, char* argv[], ProgramArgs& args)
             args.num_retries = std::stoull(optarg);
             break;
 
+        case 'p': // number of threads populating the store
+            args.populate_threads = std::stoull(optarg);
+            break;
+
+        case 'b': // number of pairs per populate transaction
+            args.populate_batch = std::stoull(optarg);
+            break;
+
         case 'u': // time unit
             args.unit = optarg;
             break;
 
+        case 'a': // contiguous arena
+            args.arena = true;
+            break;
+
+        case 'g': // contiguous arena backed by huge pages
+            args.arena = true;
+            args.huge_pages = true;
+            break;
+
+        case 's': // stream workload from file
+            args.stream = true;
+            break;
+
         case 'v': // verbose mode
             args.verbose = true;
             break;
@@ -164,14 +242,26 @@ bool validate_args(ProgramArgs& args)
         std::cout << "error: no sample data provided (see option -d)\n";
         return false;
     }
-    else if (args.workload_file.empty()) {
-        std::cout << "error: no transaction profiles provided (see option -p)\n";
+    else if (args.workload_file.empty() && args.tx_profile_file.empty()) {
+        std::cout << "error: no workload or transaction profiles provided (see options -w and -x)\n";
+        return false;
+    }
+    else if (!args.workload_file.empty() && !args.tx_profile_file.empty()) {
+        std::cout << "error: a workload and transaction profiles cannot be used together (see options -w and -x)\n";
+        return false;
+    }
+    else if (args.partitioned && args.tx_profile_file.empty()) {
+        std::cout << "error: only generated transactions can be partitioned (see options -P and -x)\n";
         return false;
     }
     else if (args.num_threads < 1) {
         std::cout << "error: spawning less than 1 thread is not possible (see option -t)\n";
         return false;
     }
+    else if (args.populate_threads < 1) {
+        std::cout << "error: populating with less than 1 thread is not possible (see option -p)\n";
+        return false;
+    }
     else if (args.smt_ratio < 1) {
         std::cout << "error: each CPU should have at least one hardware thread (see option -m)\n";
         return false;
@@ -187,11 +277,24 @@ void print_args(ProgramArgs& args)
 {
     std::cout << "data_file: " << args.data_file << std::endl;
     std::cout << "workload_file: " << args.workload_file << std::endl;
+    std::cout << "tx_profile_file: " << args.tx_profile_file << std::endl;
+    std::cout << "num_txs: " << args.num_txs << std::endl;
+    std::cout << "tx_length_min: " << args.tx_length_min << std::endl;
+    std::cout << "tx_length_max: " << args.tx_length_max << std::endl;
+    std::cout << "num_loaded: " << args.num_loaded << std::endl;
+    std::cout << "partitioned: " << args.partitioned << std::endl;
+    std::cout << "cross_prob: " << args.cross_prob << std::endl;
+    std::cout << "seed: " << args.seed << std::endl;
     std::cout << "num_threads: " << args.num_threads << std::endl;
     std::cout << "cpu_offset: " << args.cpu_offset << std::endl;
     std::cout << "smt_ratio: " << args.smt_ratio << std::endl;
     std::cout << "num_retries: " << args.num_retries << std::endl;
+    std::cout << "populate_threads: " << args.populate_threads << std::endl;
+    std::cout << "populate_batch: " << args.populate_batch << std::endl;
     std::cout << "unit: " << args.unit << std::endl;
+    std::cout << "arena: " << args.arena << std::endl;
+    std::cout << "huge_pages: " << args.huge_pages << std::endl;
+    std::cout << "stream: " << args.stream << std::endl;
 }
 
 } // end namespace bench
@@ -0,0 +1,163 @@
+#ifndef WORKLOAD_STREAM_HPP
+#define WORKLOAD_STREAM_HPP
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+
+#include "workload.hpp"
+#include "tx-gen.hpp"
+
+namespace bench {
+namespace tools {
+
+// Number of commands a block of a workload stream holds by default
+constexpr std::size_t WORKLOAD_STREAM_BLOCK_SIZE = 1ULL << 16;
+
+/**
+ * Range [first_tx, last_tx) of the transactions of a workload stream. When
+ * generating, cursor holds the inserts and deletes before first_tx (see
+ * TxGenerator::countKeyChanges).
+ */
+struct WorkloadRange
+{
+    std::size_t first_tx = 0;
+    std::size_t last_tx = 0;
+    tx_cursor_t cursor;
+};
+
+using workload_range_t = WorkloadRange;
+
+/**
+ * Reads ranges of transactions of a binary workload file (plain or packed)
+ * on the fly, or generates them from transaction profiles.
+ *
+ * Transactions are read in blocks of about block_size commands into two
+ * buffers. While the caller runs the transactions of one block, a
+ * background thread reads the next one into the other buffer. Memory use
+ * thus only depends on the block size (and the longest transaction), not on
+ * the size of the workload.
+ */
+class WorkloadStream
+{
+public:
+    WorkloadStream() = default;
+    WorkloadStream(const WorkloadStream&) = delete;
+    WorkloadStream& operator=(const WorkloadStream&) = delete;
+    ~WorkloadStream();
+
+    /**
+     * Starts reading transactions [first_tx, last_tx) of a binary workload.
+     * All positions must be less than num_pairs, the size of the data set
+     * the workload is run on, or reading the block fails.
+     */
+    int open(const std::string& filePath, std::uint64_t num_pairs, std::size_t first_tx,
+            std::size_t last_tx, std::size_t block_size = WORKLOAD_STREAM_BLOCK_SIZE)
+    {
+        return open(filePath, num_pairs, {{first_tx, last_tx, {}}}, block_size);
+    }
+
+    /**
+     * Starts reading the transactions of the given ranges of a binary
+     * workload, one range after the other. Ranges must be in ascending order
+     * and must not overlap.
+     */
+    int open(const std::string& filePath, std::uint64_t num_pairs,
+            const std::vector<workload_range_t>& ranges,
+            std::size_t block_size = WORKLOAD_STREAM_BLOCK_SIZE);
+
+    /**
+     * Starts generating transactions [first_tx, last_tx), where cursor holds
+     * the inserts and deletes before first_tx (see
+     * TxGenerator::countKeyChanges). The generator must outlive the stream.
+     */
+    int open(const tx_generator_t& generator, std::size_t first_tx, std::size_t last_tx,
+            tx_cursor_t cursor = {}, std::size_t block_size = WORKLOAD_STREAM_BLOCK_SIZE)
+    {
+        return open(generator, {{first_tx, last_tx, cursor}}, block_size);
+    }
+
+    /**
+     * Starts generating the transactions of the given ranges, like reading
+     * them.
+     */
+    int open(const tx_generator_t& generator, const std::vector<workload_range_t>& ranges,
+            std::size_t block_size = WORKLOAD_STREAM_BLOCK_SIZE);
+    void close();
+
+    /**
+     * Waits until the first block has been read or generated, e.g. to start
+     * timing only then. Returns 1 if it could not be read.
+     */
+    int waitReady();
+
+    /**
+     * Returns transaction i, which must be part of a range and must not
+     * precede any transaction requested before. The returned view stays
+     * valid until a later transaction is requested. Throws
+     * std::runtime_error if the block holding it could not be read.
+     */
+    workload_tx_t operator[](std::size_t i)
+    {
+        if (i - current_first < current_size)
+            return current_tx(i);
+        return advance(i);
+    }
+
+private:
+    struct Block
+    {
+        std::size_t first_tx = 0;
+        std::vector<std::uint64_t> offsets; // relative to the first command of the block
+        std::vector<workload_cmd_t> cmds;
+        bool ready = false;
+        bool failed = false;
+    };
+
+    workload_tx_t current_tx(std::size_t i) const
+    {
+        const auto& block = blocks[current];
+        const auto j = i - current_first;
+        return {block.cmds.data() + block.offsets[j], block.cmds.data() + block.offsets[j + 1]};
+    }
+
+    int start(const std::vector<workload_range_t>& ranges, std::size_t num_txs, std::size_t block_size);
+    workload_tx_t advance(std::size_t i);
+    void prefetch();
+    bool fill(Block& block, std::size_t first_tx);
+    bool read(Block& block, std::size_t first_tx);
+    bool readPacked(Block& block, std::size_t first_tx);
+    void generate(Block& block, std::size_t first_tx);
+
+    int fd = -1;
+    std::vector<workload_block_entry_t> table; // packed workloads only
+    std::vector<char> packed;                  // encoded block being read
+    std::uint64_t num_pairs = 0;               // bound of the positions read
+    const tx_generator_t* generator = nullptr;
+    tx_cursor_t cursor;                        // inserts and deletes before the next generated transaction
+    workload_header_t header;
+    std::vector<workload_range_t> ranges;
+    std::size_t last_tx = 0;                   // end of the range being read
+    std::size_t block_size = 0;
+
+    Block blocks[2];
+    std::size_t current = 0;        // block the caller reads from
+    std::size_t current_first = 0;  // first transaction of that block
+    std::size_t current_size = 0;   // number of transactions of that block, 0 = not acquired yet
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool stopped = false;
+    std::thread prefetcher;
+};
+
+using workload_stream_t = WorkloadStream;
+
+} // end namespace tools
+} // end namespace bench
+
+#endif
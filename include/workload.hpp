@@ -3,23 +3,282 @@
 
 #include <string>
 #include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 
 #include "opcode.hpp"
+#include "dataset.hpp" // MappedFile
 
 namespace bench {
 namespace tools {
 
-struct workload_cmd_t
+constexpr unsigned WORKLOAD_OPCODE_SHIFT = 56;
+constexpr std::uint64_t WORKLOAD_POS_MASK = (1ULL << WORKLOAD_OPCODE_SHIFT) - 1;
+
+/**
+ * Command of a workload packed into 8 bytes: the opcode is stored in the
+ * upper 8 bits and the position in the lower 56 bits. This is the same
+ * encoding binary workload files use.
+ */
+class WorkloadCmd
+{
+public:
+    WorkloadCmd() = default;
+    WorkloadCmd(tx_opcode_t opcode, std::uint64_t pos)
+        : bits{static_cast<std::uint64_t>(opcode) << WORKLOAD_OPCODE_SHIFT | (pos & WORKLOAD_POS_MASK)}
+    {}
+
+    tx_opcode_t opcode() const { return static_cast<tx_opcode_t>(bits >> WORKLOAD_OPCODE_SHIFT); }
+    std::uint64_t pos() const { return bits & WORKLOAD_POS_MASK; }
+
+private:
+    std::uint64_t bits = 0;
+};
+
+using workload_cmd_t = WorkloadCmd;
+
+static_assert(sizeof(workload_cmd_t) == sizeof(std::uint64_t), "commands must be packed into 8 bytes");
+
+/**
+ * View of the commands of one transaction.
+ */
+class WorkloadTx
+{
+public:
+    WorkloadTx(const workload_cmd_t* first, const workload_cmd_t* last)
+        : first{first}
+        , last{last}
+    {}
+
+    const workload_cmd_t* begin() const { return first; }
+    const workload_cmd_t* end() const { return last; }
+    std::size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    const workload_cmd_t& operator[](std::size_t i) const { return first[i]; }
+
+private:
+    const workload_cmd_t* first;
+    const workload_cmd_t* last;
+};
+
+using workload_tx_t = WorkloadTx;
+
+struct WorkloadHeader;
+
+/**
+ * Sequence of transactions.
+ *
+ * The commands of all transactions are stored back to back in a single
+ * array (compressed sparse row layout). Transaction i spans commands
+ * [offsets[i], offsets[i+1]).
+ *
+ * A workload is built by appending the commands of a transaction and then
+ * finishing the transaction.
+ *
+ * A workload may be divided into phases, e.g. of different transaction
+ * profiles, which are run one after the other. Phase p spans transactions
+ * [phases[p], phases[p+1]), the last one up to the end. Without phases, the
+ * workload is a single phase.
+ */
+class Workload
 {
-    tx_opcode_t opcode;
-    size_t pos;
+public:
+    std::size_t size() const { return offsets.size() - 1; }
+    bool empty() const { return size() == 0; }
+    std::size_t numCmds() const { return cmds.size(); }
+
+    workload_tx_t operator[](std::size_t i) const
+    {
+        return {cmds.data() + offsets[i], cmds.data() + offsets[i + 1]};
+    }
+
+    void reserve(std::size_t num_txs, std::size_t num_cmds)
+    {
+        offsets.reserve(num_txs + 1);
+        cmds.reserve(num_cmds);
+    }
+
+    void clear()
+    {
+        offsets.assign(1, 0);
+        cmds.clear();
+        phases.clear();
+    }
+
+    void appendCmd(workload_cmd_t cmd) { cmds.push_back(cmd); }
+    void finishTx() { offsets.push_back(cmds.size()); }
+
+    /**
+     * Appends all transactions of other.
+     */
+    void append(const Workload& other)
+    {
+        const auto base = cmds.size();
+        cmds.insert(cmds.end(), other.cmds.begin(), other.cmds.end());
+        for (auto it = other.offsets.begin() + 1; it != other.offsets.end(); ++it)
+            offsets.push_back(base + *it);
+    }
+
+    const std::vector<workload_cmd_t>& commands() const { return cmds; }
+    const std::vector<std::uint64_t>& txOffsets() const { return offsets; }
+
+    /**
+     * Returns the first transaction of each phase, or nothing if the
+     * workload is not divided into phases.
+     */
+    const std::vector<std::uint64_t>& phaseStarts() const { return phases; }
+    void setPhases(std::vector<std::uint64_t> starts) { phases = std::move(starts); }
+
+private:
+    friend int parseBinaryWorkload(const MappedFile& file, Workload& workload);
+    friend int parsePackedWorkload(const MappedFile& file, const WorkloadHeader& header, Workload& workload);
+
+    std::vector<workload_cmd_t> cmds;
+    std::vector<std::uint64_t> offsets{0};
+    std::vector<std::uint64_t> phases;
 };
 
-using workload_tx_t = std::vector<workload_cmd_t>;
-using workload_t = std::vector<workload_tx_t>;
+using workload_t = Workload;
+
+/**
+ * Returns true if starts are the first transactions of the phases of a
+ * workload of num_txs transactions: the first phase starts at 0 and each
+ * phase has at least one transaction.
+ */
+inline bool validPhaseStarts(const std::vector<std::uint64_t>& starts, std::uint64_t num_txs)
+{
+    for (std::size_t p = 0; p < starts.size(); ++p) {
+        if (p ? starts[p] <= starts[p - 1] || starts[p] >= num_txs : starts[p] != 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Returns the first of size items of part part, when the items are split
+ * into num_parts contiguous parts of (almost) the same size. The first
+ * size % num_parts parts get one item more.
+ */
+inline std::size_t partBegin(std::size_t size, std::size_t num_parts, std::size_t part)
+{
+    return size / num_parts * part + std::min(part, size % num_parts);
+}
+
+/**
+ * Returns the part the item at index belongs to (see partBegin).
+ */
+inline std::size_t partOf(std::size_t size, std::size_t num_parts, std::size_t index)
+{
+    const auto each = size / num_parts;
+    const auto boundary = size % num_parts * (each + 1);
+    return index < boundary ? index / (each + 1) : size % num_parts + (index - boundary) / each;
+}
+
+/**
+ * Header of binary workload files.
+ *
+ * In the plain layout (WORKLOAD_VERSION_PLAIN), the header is followed by a
+ * table of num_txs + 1 command indexes and num_cmds packed commands.
+ * Transaction i spans commands [offsets[i], offsets[i+1]). Each command is a
+ * 64-bit integer holding the opcode in its upper 8 bits and the position in
+ * its lower 56 bits.
+ *
+ * In the packed layout (WORKLOAD_VERSION_PACKED), transactions are grouped
+ * into blocks of WORKLOAD_PACKED_BLOCK_TXS. The header is followed by a table
+ * of num_blocks + 1 block entries and the encoded blocks (see
+ * decodeWorkloadBlock).
+ *
+ * In both layouts, the file ends with the first transactions of num_phases
+ * phases (see Workload::phaseStarts), one 64-bit integer each.
+ *
+ * Integers are stored in host byte order.
+ */
+struct WorkloadHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t num_phases;
+    std::uint64_t num_txs;
+    std::uint64_t num_cmds;
+};
+
+using workload_header_t = WorkloadHeader;
+
+constexpr char WORKLOAD_MAGIC[8] = {'K', 'V', 'W', 'O', 'R', 'K', 0, 0};
+constexpr std::uint32_t WORKLOAD_VERSION_PLAIN = 1;
+constexpr std::uint32_t WORKLOAD_VERSION_PACKED = 2;
+
+// Number of transactions per block of a packed workload
+constexpr std::size_t WORKLOAD_PACKED_BLOCK_TXS = 1024;
+
+/**
+ * Entry of the block table of a packed workload. Block b starts at byte
+ * offset (relative to the first block) and holds commands [first_cmd,
+ * next first_cmd). The last entry marks the end of the last block.
+ */
+struct WorkloadBlockEntry
+{
+    std::uint64_t offset;
+    std::uint64_t first_cmd;
+};
+
+using workload_block_entry_t = WorkloadBlockEntry;
+
+// Encodings of the commands of a packed block
+constexpr std::uint8_t WORKLOAD_BLOCK_DELTA = 0;
+constexpr std::uint8_t WORKLOAD_BLOCK_PACKED = 1;
+constexpr std::size_t WORKLOAD_BLOCK_HEADER_SIZE = 8;
+
+inline std::size_t numWorkloadBlocks(const workload_header_t& header)
+{
+    return (header.num_txs + WORKLOAD_PACKED_BLOCK_TXS - 1) / WORKLOAD_PACKED_BLOCK_TXS;
+}
+
+/**
+ * Decodes one block of a packed workload holding num_txs transactions with
+ * num_cmds commands in total. The end of each transaction, counted from
+ * first_cmd, is written to offsets[0..num_txs) and the commands to
+ * cmds[0..num_cmds).
+ *
+ * A block starts with 8 bytes: the encoding, the number of opcode bits, the
+ * number of position bits and 5 reserved bytes. The lengths of the
+ * transactions follow as varints. Each command is then stored as
+ * value << opcode_bits | opcode, where value is either
+ *  - the zigzag-encoded difference to the previous position of the block,
+ *    written as a varint (WORKLOAD_BLOCK_DELTA), or
+ *  - the position, bit-packed at a fixed width of at least one bit
+ *    (WORKLOAD_BLOCK_PACKED),
+ *    followed by 8 bytes of padding.
+ * The encoder picks whichever is smaller for the block.
+ */
+bool decodeWorkloadBlock(const char* data, std::size_t size, std::size_t num_txs,
+        std::size_t num_cmds, std::uint64_t first_cmd, std::uint64_t* offsets, workload_cmd_t* cmds);
+
+enum class workload_format_t { Json, Bin, Packed };
+
+/**
+ * Reads a workload in JSON or binary format. The format is detected
+ * automatically. All positions must be less than num_pairs, the size of the
+ * data set the workload is run on.
+ */
+int parseWorkload(const std::string& filePath, workload_t& workload,
+        std::uint64_t num_pairs = WORKLOAD_POS_MASK + 1);
+int writeWorkload(const std::string& filePath, const workload_t& work,
+        workload_format_t format = workload_format_t::Json);
+
+/**
+ * Reads and validates the header of a binary workload without loading any
+ * transactions.
+ */
+int readWorkloadHeader(const std::string& filePath, workload_header_t& header);
 
-int parseWorkload(const std::string& filePath, workload_t& workload);
-int writeWorkload(const std::string& filePath, const workload_t& work);
+/**
+ * Reads the first transaction of each phase of a binary workload without
+ * loading any transactions (see Workload::phaseStarts).
+ */
+int readWorkloadPhases(const std::string& filePath, std::vector<std::uint64_t>& starts);
 
 } // end namespace tools
 } // end namespace bench
@@ -16,13 +16,16 @@ if [ ! -d "bin/workload-gen" ]; then
     make workload-gen
 fi
 
+# The length ranges given here override length_min and length_max of the
+# profile, so that short and long workloads differ
+
 # generate workloads with small database
 ./bin/kv-gen $key_len $val_len 1000 assets/data/small.csv
-./bin/workload-gen --data assets/data/small.csv --tx-profile assets/profiles/sap-oltp.json --num-txs $num_txs --tx-length-min $short_min --tx-length-max $short_max -o assets/workloads/ss-1000.json
-./bin/workload-gen --data assets/data/small.csv --tx-profile assets/profiles/sap-oltp.json --num-txs $num_txs --tx-length-min $long_min --tx-length-max $long_max -o assets/workloads/sl-1000.json
+./bin/workload-gen --data assets/data/small.csv --tx-profile assets/profiles/sap-oltp.json --num-txs $num_txs --tx-length-min $short_min --tx-length-max $short_max --format packed -o assets/workloads/ss-1000.packed
+./bin/workload-gen --data assets/data/small.csv --tx-profile assets/profiles/sap-oltp.json --num-txs $num_txs --tx-length-min $long_min --tx-length-max $long_max --format packed -o assets/workloads/sl-1000.packed
 
 # generate workloads with large database
 ./bin/kv-gen $key_len $val_len 100000 assets/data/large.csv
-./bin/workload-gen --data assets/data/large.csv --tx-profile assets/profiles/sap-oltp.json --num-txs $num_txs --tx-length-min $short_min --tx-length-max $short_max -o assets/workloads/ls-1000.json
-./bin/workload-gen --data assets/data/large.csv --tx-profile assets/profiles/sap-oltp.json --num-txs $num_txs --tx-length-min $long_min --tx-length-max $long_max -o assets/workloads/ll-1000.json
+./bin/workload-gen --data assets/data/large.csv --tx-profile assets/profiles/sap-oltp.json --num-txs $num_txs --tx-length-min $short_min --tx-length-max $short_max --format packed -o assets/workloads/ls-1000.packed
+./bin/workload-gen --data assets/data/large.csv --tx-profile assets/profiles/sap-oltp.json --num-txs $num_txs --tx-length-min $long_min --tx-length-max $long_max --format packed -o assets/workloads/ll-1000.packed
 
@@ -1,10 +1,10 @@
 # assets
 data_small=assets/data/small.csv
 data_large=assets/data/large.csv
-work_small_short=assets/workloads/ss-1000.json
-work_small_long=assets/workloads/sl-1000.json
-work_large_short=assets/workloads/ls-1000.json
-work_large_long=assets/workloads/ll-1000.json
+work_small_short=assets/workloads/ss-1000.packed
+work_small_long=assets/workloads/sl-1000.packed
+work_large_short=assets/workloads/ls-1000.packed
+work_large_long=assets/workloads/ll-1000.packed
 
 # parameters
 num_threads_max=32
@@ -0,0 +1,30 @@
+#!/bin/bash
+
+sc_name=$1
+data_file=$2
+num_threads_max=$3
+batch_sizes=$4
+num_runs=$5
+
+# echo "dataset: $data_file"
+# echo "num_threads_max: $num_threads_max"
+# echo "batch sizes: $batch_sizes"
+# echo "#runs per config: $num_runs"
+
+folder="log/`date +%Y%m%d-%H%M%S`-echo-load-$sc_name"
+mkdir $folder
+
+for ((n=1; n<=$num_threads_max; n=2*n))
+do
+    for b in ${batch_sizes//,/ }
+    do
+        echo "running benchmark with $n thread(s) and batches of $b pair(s)"
+        for ((i=1; i<=$num_runs; i++))
+        do
+            echo -n "starting run $i/$num_runs ... "
+            echo "--------------------------------" >> $folder/echo-load-$sc_name-$n-$b.log
+            ./bin/echo-load --data $data_file --num-threads $n --batch $b >> $folder/echo-load-$sc_name-$n-$b.log
+            echo "done!"
+        done
+    done
+done
@@ -4,12 +4,15 @@
 #include <fstream>  // std::ifstream
 #include <chrono>   // std::chrono::high_resolution_clock, std::chrono::duration
 #include <cmath>    // std::ceil, std::log10
-#include <algorithm>// std::min_element, std::max_element
+#include <algorithm>// std::min_element, std::max_element, std::shuffle
+#include <numeric>  // std::iota
 #include <random>   // std::random_device, std::uniform_int_distribution
 #include <stdexcept>// std::invalid_argument
 
 #include <getopt.h> // getopt_long
 
+#include "dataset.hpp"
+
 #define PERSISTENT_HEAP "/dev/shm/nvdimm_echo"
 
 extern "C" {
@@ -32,11 +35,11 @@ struct program_args {
     std::string data_file;
     std::size_t num_repeats = 1000;
     std::string unit = "s";
+    bool arena = false;
+    bool huge_pages = false;
     bool verbose = false;
 };
 
-using kvpair_t = std::pair<std::string, std::string>;
-
 // typedef struct random_ints_ {
 //   int *array;
 //   unsigned int count;
@@ -48,7 +51,7 @@ typedef struct benchmark_args_struct {
     cpu_set_t cpu_set;
     void *master;
     program_args *pargs;
-    std::vector<kvpair_t> *pairs;
+    bench::tools::dataset_t *pairs;
     // int num_threads;
     // int starting_ops;
     // pthread_cond_t *bench_cond;
@@ -77,38 +80,6 @@ __attribute__((always_inline)) inline void DoNotOptimize(const T &value) {
       asm volatile("" : "+m"(const_cast<T &>(value)));
 }
 
-std::vector<kvpair_t> fetch_data(std::string path)
-{
-    std::ifstream ifs{path};
-    if (!ifs.is_open())
-        return {};
-
-    std::string line;
-    // std::getline(ifs, line);
-    // std::size_t key_size = std::stoi(line);
-    // std::getline(ifs, line);
-    // std::size_t val_size = std::stoi(line);
-    // std::getline(ifs, line);
-    // std::size_t num_pairs = std::stoi(line);
-
-    std::vector<kvpair_t> pairs;
-    while (std::getline(ifs, line)) {
-        if (!line.empty()) {
-            auto pos_delim = line.find(';');
-            if (pos_delim != std::string::npos) {
-                pairs.emplace_back(
-                    line.substr(0, pos_delim), // get chars before delimiter
-                    line.substr(pos_delim + 1) // get chars after delimiter
-                );
-            }
-            else {
-                throw std::invalid_argument("error: missing delimiter (;) in line");
-            }
-        }
-    }
-    return pairs;
-}
-
 void measure_empty_store(kp_kv_local *local, benchmark_thread_args* args, std::vector<std::chrono::duration<double>>& latencies)
 {
     // TODO how to determine key size and value size for empty store?
@@ -124,19 +95,20 @@ void measure_populated_store(kp_kv_local *local, benchmark_thread_args* thread_a
 
     std::random_device rand_dev;
     std::mt19937 rng(rand_dev());
-    std::uniform_int_distribution<> dist(0, pairs.size() - 1); // use: dist(rng)
+    std::uniform_int_distribution<std::size_t> dist(0, pairs.size() - 1); // use: dist(rng)
+
+    std::string key_buf;
 
     if (opcode == "get") {
         int rc;
         for (size_t i=0; i<num_repeats; ++i) {
-            const auto& [_key, _val] = pairs[dist(rng)];
-            (void)_val;
+            const auto _key = pairs[dist(rng)].first;
             if (thread_args->pargs->verbose) {
                 std::cout << "get(\n";
                 std::cout << "\tkey = " << _key << '\n';
                 std::cout << ")\n";
             }
-            const char* key = _key.c_str();
+            const char* key = pairs.cstr(_key, key_buf);
             char* val;
             std::size_t siz;
 
@@ -155,15 +127,15 @@ void measure_populated_store(kp_kv_local *local, benchmark_thread_args* thread_a
     else if (opcode == "put") {
         int rc;
         for (size_t i=0; i<num_repeats; ++i) {
-            const auto& [_key, _val] = pairs[dist(rng)];
+            const auto [_key, _val] = pairs[dist(rng)];
             if (thread_args->pargs->verbose) {
                 std::cout << "put(\n";
                 std::cout << "\tkey = " << _key << '\n';
                 std::cout << "\tval = " << _val << '\n';
                 std::cout << ")\n";
             }
-            const char* key = _key.c_str();
-            const char* val = _val.c_str();
+            const char* key = pairs.cstr(_key, key_buf);
+            const char* val = _val.data();
             const std::size_t siz = _val.size();
 
             const auto start = std::chrono::high_resolution_clock::now();
@@ -177,10 +149,56 @@ void measure_populated_store(kp_kv_local *local, benchmark_thread_args* thread_a
         }
     }
     else if (opcode == "ins") {
-        // TODO not really required (not used in throughput benchmark) 
+        // The last num_repeats pairs are not populated, so each insert
+        // writes a key the store does not hold yet
+        int rc;
+        for (size_t i=pairs.size() - num_repeats; i<pairs.size(); ++i) {
+            const auto [_key, _val] = pairs[i];
+            if (thread_args->pargs->verbose) {
+                std::cout << "ins(\n";
+                std::cout << "\tkey = " << _key << '\n';
+                std::cout << "\tval = " << _val << '\n';
+                std::cout << ")\n";
+            }
+            const char* key = pairs.cstr(_key, key_buf);
+            const char* val = _val.data();
+            const std::size_t siz = _val.size();
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            DoNotOptimize(local); 
+            rc = kp_local_put(local, key, val, siz);
+            (void)rc;
+            DoNotOptimize(rc);
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            latencies.emplace_back(end - start);
+        }
     }
     else if (opcode == "del") {
-        // TODO not really required (not used in throughput benchmark) 
+        // Each delete removes another key
+        std::vector<std::size_t> order(pairs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+
+        int rc;
+        for (size_t i=0; i<num_repeats; ++i) {
+            const auto _key = pairs[order[i]].first;
+            if (thread_args->pargs->verbose) {
+                std::cout << "del(\n";
+                std::cout << "\tkey = " << _key << '\n';
+                std::cout << ")\n";
+            }
+            const char* key = pairs.cstr(_key, key_buf);
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            DoNotOptimize(local); 
+            rc = kp_local_delete_key(local, key);
+            (void)rc;
+            DoNotOptimize(rc);
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            latencies.emplace_back(end - start);
+        }
     }
 
     // // Starting a transaction
@@ -270,9 +288,14 @@ void *little_latency_wrapper(void *arg)
 
     auto& pairs = *thread_args->pairs;
     if (pairs.size()) {
+        // Pairs to be inserted are left out
+        const auto& pargs = *thread_args->pargs;
+        const auto num_populated = pargs.opcode == "ins" ? pairs.size() - pargs.num_repeats : pairs.size();
+        std::string key_buf;
         PM_START_TX();
-        for (auto [key, value] : pairs) {
-            rc = kp_local_put(local, key.c_str(), value.c_str(), value.size());
+        for (std::size_t i = 0; i < num_populated; ++i) {
+            const auto [key, value] = pairs[i];
+            rc = kp_local_put(local, pairs.cstr(key, key_buf), value.data(), value.size());
             if (rc)
             std::cout << "status code: " << rc << std::endl;
         }
@@ -313,9 +336,20 @@ void *little_latency_wrapper(void *arg)
 
 int run(program_args* pargs)
 {
-    std::vector<kvpair_t> pairs;
-    if (!pargs->data_file.empty())
-        pairs = fetch_data(pargs->data_file);
+    bench::tools::dataset_t pairs;
+    if (!pargs->data_file.empty() && bench::tools::loadDataset(pargs->data_file, pairs)) {
+        std::cout << "error: could not read pairs from file " << pargs->data_file << "!\n";
+        return 0;
+    }
+    if (pargs->arena && bench::tools::compactDataset(pairs, pargs->huge_pages)) {
+        std::cout << "error: could not copy pairs into arena!\n";
+        return 0;
+    }
+    if ((pargs->opcode == "ins" || pargs->opcode == "del") && pargs->num_repeats > pairs.size()) {
+        std::cout << "error: cannot " << pargs->opcode << " " << pargs->num_repeats << " of "
+            << pairs.size() << " pairs!\n";
+        return 0;
+    }
 
     // for (auto [key, val] : pairs) {
     //     std::cout << key.substr(0,3) << "..." << key.substr(key.size() - 3);
@@ -410,16 +444,21 @@ void usage()
     std::cout << "\tput\n";
     std::cout << "\t\tUpdate.\n";
     std::cout << "\tins\n";
-    std::cout << "\t\tInsertion (currently not supported).\n";
+    std::cout << "\t\tInsertion of keys left out when populating.\n";
     std::cout << "\tget\n";
     std::cout << "\t\tRetrieval.\n";
     std::cout << "\tdel\n";
-    std::cout << "\t\tDeletion (currently not supported).\n";
+    std::cout << "\t\tDeletion of distinct keys.\n";
     std::cout << "\nOPTIONS\n";
     std::cout << "\t-p, --populate FILE\n";
     std::cout << "\t\tPopulates the database with data from the specified file.\n";
+    std::cout << "\t\tAlternatively, proc:NUM_PAIRS:KEY_SIZE:VAL_SIZE[:SEED] derives pairs on the fly without a file.\n";
     std::cout << "\t-r, --repeats NUM\n";
     std::cout << "\t\tSets the number of repetitions for the given operation (default = 1000).\n";
+    std::cout << "\t-a, --arena\n";
+    std::cout << "\t\tCopies the sample data into a contiguous arena before populating.\n";
+    std::cout << "\t-g, --huge-pages\n";
+    std::cout << "\t\tLike --arena but backs the arena with transparent huge pages.\n";
     std::cout << "\t-u, --unit UNIT\n";
     std::cout << "\t\tSets the time unit of used when printing results. Can be one of {s | ms | us | ns} (default = s).\n";
     std::cout << "\t-v, --verbose\n";
@@ -444,13 +483,15 @@ void parse_args(int argc, char* argv[], program_args& pargs)
         { "repeats"  , required_argument , NULL , 'r' },
         { "populate" , required_argument , NULL , 'p' },
         { "unit"     , required_argument , NULL , 'u' },
+        { "arena"    , no_argument       , NULL , 'a' },
+        { "huge-pages", no_argument      , NULL , 'g' },
         { "verbose"  , no_argument       , NULL , 'v' },
         { "help"     , no_argument       , NULL , 'h' },
         { NULL       , 0                 , NULL , 0 }
     };
 
     char ch;
-    while ((ch = getopt_long(argc, argv, "r:p:u:v", longopts, NULL)) != -1) {
+    while ((ch = getopt_long(argc, argv, "r:p:u:agv", longopts, NULL)) != -1) {
         switch (ch) {
         case 'r':
             pargs.num_repeats = std::stoll(optarg);
@@ -464,6 +505,15 @@ void parse_args(int argc, char* argv[], program_args& pargs)
             pargs.unit = optarg;
             break;
 
+        case 'a':
+            pargs.arena = true;
+            break;
+
+        case 'g':
+            pargs.arena = true;
+            pargs.huge_pages = true;
+            break;
+
         case 'v':
             pargs.verbose = true;
             break;
@@ -492,6 +542,8 @@ void print_args(program_args& pargs)
     std::cout << "repeats : " << pargs.num_repeats << std::endl;
     std::cout << "datafile: " << pargs.data_file << std::endl;
     std::cout << "unit    : " << pargs.unit << std::endl;
+    std::cout << "arena   : " << pargs.arena << std::endl;
+    std::cout << "hugepage: " << pargs.huge_pages << std::endl;
     std::cout << "verbose : " << pargs.verbose << std::endl;
 }
 
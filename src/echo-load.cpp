@@ -0,0 +1,266 @@
+#include <iostream> // std::cout, std::endl
+#include <string>   // std::string
+#include <cstdint>  // std::uint64_t
+
+#include <sys/resource.h> // getrusage
+#include <sys/stat.h>     // stat
+#include <unistd.h>       // unlink
+
+#define PERSISTENT_HEAP "/dev/shm/nvdimm_echo"
+
+extern "C" {
+#include "kp_kv_local.h"    // local store
+#include "kp_kv_master.h"   // master store
+#include "kp_macros.h"      // kp_die()
+#include "clibpm.h"         // PMSIZE, pmemalloc_init
+#include "kp_recovery.h"
+}
+
+#include "dataset.hpp"
+#include "duration.hpp"
+#include "populate.hpp"
+
+#include <getopt.h> // getopt_long
+
+namespace bench {
+
+struct ProgramArgs {
+    std::string data_file;
+    std::size_t num_threads = 1;
+    std::size_t batch_size = 0;
+    std::string unit = "s";
+    bool arena = false;
+    bool huge_pages = false;
+    bool verbose = false;
+};
+
+/**
+ * Writes ranges of pairs for populate(), each in a single transaction of its
+ * own local store.
+ */
+class BatchWriter {
+public:
+    BatchWriter(kp_kv_master* master, const tools::dataset_t& pairs, std::size_t batch_size)
+        : pairs{pairs}
+    {
+        if (kp_kv_local_create(master, &local, batch_size ? batch_size : pairs.size(), false))
+            std::cout << "error: creating local store for loading failed!\n";
+    }
+    BatchWriter(const BatchWriter&) = delete;
+    BatchWriter& operator=(const BatchWriter&) = delete;
+    ~BatchWriter() { kp_kv_local_destroy(&local); }
+
+    bool operator()(std::size_t first, std::size_t last)
+    {
+        PM_START_TX();
+        for (std::size_t i = first; i < last; ++i) {
+            const auto [key, val] = pairs[i];
+            const auto rc = kp_local_put(local, pairs.cstr(key, key_buf), val.data(), val.size());
+            if (rc)
+                std::cout << "status code: " << rc << std::endl;
+        }
+
+        // 0 = success, 1 = conflict, -1 = error, 2 = empty commit
+        const auto rc = kp_local_commit(local, NULL);
+        if (rc == 0 || rc == 2) {
+            PM_END_TX();
+            return true;
+        }
+        return false;
+    }
+
+private:
+    const tools::dataset_t& pairs;
+    kp_kv_local* local = nullptr;
+    std::string key_buf;
+};
+
+/**
+ * Returns the number of bytes the file system has allocated for a file.
+ */
+std::uint64_t allocated_bytes(const char* path)
+{
+    struct stat st;
+    if (::stat(path, &st))
+        return 0;
+    return st.st_blocks * 512ULL;
+}
+
+int run(ProgramArgs* pargs)
+{
+    tools::dataset_t pairs;
+    if (tools::loadDataset(pargs->data_file, pairs)) {
+        std::cout << "error: could not read pairs from file " << pargs->data_file << "!\n";
+        return 1;
+    }
+    if (pargs->arena && tools::compactDataset(pairs, pargs->huge_pages)) {
+        std::cout << "error: could not copy pairs into arena!\n";
+        return 1;
+    }
+
+    if (pargs->verbose)
+        std::cout << "initializing store..." << std::endl;
+
+    // Always load into an empty pool
+    ::unlink(PERSISTENT_HEAP);
+
+    void *pmp;
+    if ((pmp = pmemalloc_init(PERSISTENT_HEAP, (size_t)PMSIZE)) == NULL) {
+        std::cout << "error: unable to allocate memory pool!\n";
+        return 1;
+    }
+    const auto allocated_start = allocated_bytes(PERSISTENT_HEAP);
+
+    kp_kv_master* master;
+    auto ret = kp_kv_master_create(
+            &master,
+            MODE_SNAPSHOT,
+            pairs.size(),  // expected max no keys
+            true, // enable conflict detection
+            true  // enable NVM usage
+    );
+    if (ret) {
+        std::cout << "error: master store could not be created!\n";
+        return 1;
+    }
+
+    if (pargs->verbose)
+        std::cout << "loading..." << std::endl;
+
+    auto result = populate(pairs, pargs->num_threads, pargs->batch_size,
+            [&]() { return BatchWriter{master, pairs, pargs->batch_size}; });
+
+    std::cout << "threads=" << pargs->num_threads << std::endl;
+    std::cout << "batch=" << pargs->batch_size << std::endl;
+    print_populate_result(result, pargs->unit);
+
+    // Pages of a pool file on tmpfs are only allocated once they are written
+    // to, so the growth of the file tells how much of the pool is in use
+    std::cout << "pool bytes=" << (allocated_bytes(PERSISTENT_HEAP) - allocated_start) << std::endl;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "peak rss=" << (usage.ru_maxrss * 1024ULL) << std::endl;
+
+    kp_kv_master_destroy(master);
+    return 0;
+}
+
+void usage()
+{
+    ProgramArgs pargs;
+    std::cout << "NAME\n";
+    std::cout << "\tload - determine how fast sample data is loaded into an empty store\n";
+    std::cout << "\nSYNOPSIS\n";
+    std::cout << "\tload options\n";
+    std::cout << "\nOPTIONS\n";
+    std::cout << "\t-d, --data FILE\n";
+    std::cout << "\t\tPath to a file containing sample data pairs in CSV or binary format. This parameter is required.\n";
+    std::cout << "\t\tAlternatively, proc:NUM_PAIRS:KEY_SIZE:VAL_SIZE[:SEED] derives pairs on the fly without a file.\n";
+    std::cout << "\t-t, --num-threads INT\n";
+    std::cout << "\t\tThe number of threads writing pairs. (default = " << pargs.num_threads << ")\n";
+    std::cout << "\t-b, --batch INT\n";
+    std::cout << "\t\tThe number of pairs written per transaction.\n";
+    std::cout << "\t\t0 writes all pairs of a thread in a single transaction. (default = " << pargs.batch_size << ")\n";
+    std::cout << "\t-a, --arena\n";
+    std::cout << "\t\tCopies the sample data into a contiguous arena before loading.\n";
+    std::cout << "\t-g, --huge-pages\n";
+    std::cout << "\t\tLike --arena but backs the arena with transparent huge pages.\n";
+    std::cout << "\t-u, --unit UNIT\n";
+    std::cout << "\t\tSets the time unit of used when printing results. Can be one of {s | ms | us | ns} (default = " << pargs.unit << ").\n";
+    std::cout << "\t-v, --verbose\n";
+    std::cout << "\t\tPrint additional info.\n";
+    std::cout << "\t-h, --help\n";
+    std::cout << "\t\tShow this help text.\n";
+}
+
+void parse_args(int argc, char* argv[], ProgramArgs& pargs)
+{
+    static struct option longopts[] = {
+        { "data"       , required_argument , NULL , 'd' },
+        { "num-threads", required_argument , NULL , 't' },
+        { "batch"      , required_argument , NULL , 'b' },
+        { "unit"       , required_argument , NULL , 'u' },
+        { "arena"      , no_argument       , NULL , 'a' },
+        { "huge-pages" , no_argument       , NULL , 'g' },
+        { "verbose"    , no_argument       , NULL , 'v' },
+        { "help"       , no_argument       , NULL , 'h' },
+        { NULL         , 0                 , NULL , 0 }
+    };
+
+    char ch;
+    while ((ch = getopt_long(argc, argv, "d:t:b:u:aghv", longopts, NULL)) != -1) {
+        switch (ch) {
+        case 'd':
+            pargs.data_file = optarg;
+            break;
+
+        case 't':
+            pargs.num_threads = std::stoull(optarg);
+            break;
+
+        case 'b':
+            pargs.batch_size = std::stoull(optarg);
+            break;
+
+        case 'u':
+            pargs.unit = optarg;
+            break;
+
+        case 'a':
+            pargs.arena = true;
+            break;
+
+        case 'g':
+            pargs.arena = true;
+            pargs.huge_pages = true;
+            break;
+
+        case 'v':
+            pargs.verbose = true;
+            break;
+
+        case 'h':
+        default:
+            usage();
+            exit(0);
+        }
+    }
+}
+
+bool validate_args(ProgramArgs& pargs)
+{
+    if (pargs.data_file.empty()) {
+        std::cout << "error: no sample data provided (see option -d)\n";
+        return false;
+    }
+    else if (pargs.num_threads < 1) {
+        std::cout << "error: loading with less than 1 thread is not possible (see option -t)\n";
+        return false;
+    }
+    else if (pargs.unit != "s" && pargs.unit != "ms" && pargs.unit != "us" && pargs.unit != "ns") {
+        std::cout << "error: invalid time unit (see option -u)\n";
+        return false;
+    }
+    return true;
+}
+
+} // end namespace bench
+
+int main(int argc, char* argv[])
+{
+    using namespace bench;
+
+    if (argc < 2) {
+        usage();
+        exit(0);
+    }
+
+    ProgramArgs pargs;
+    parse_args(argc, argv, pargs);
+    if (!validate_args(pargs)) {
+        usage();
+        return 1;
+    }
+    return run(&pargs);
+}
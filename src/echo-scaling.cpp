@@ -19,22 +19,38 @@ extern "C" {
 
 #include "utils.hpp"
 #include "opcode.hpp"
+#include "dataset.hpp"
 #include "workload.hpp"
+#include "workload-stream.hpp"
+#include "tx-profile.hpp"
+#include "tx-gen.hpp"
+#include "populate.hpp"
 
 namespace bench {
 
 const std::size_t NUM_THREADS_MAX = 256;
 
+struct PhaseResult {
+    std::size_t num_txs = 0;
+    std::size_t num_failures = 0;
+    std::size_t num_canceled_txs = 0;
+    std::chrono::high_resolution_clock::time_point start;
+    std::chrono::high_resolution_clock::time_point end;
+};
+
 struct BenchThreadResult {
     std::size_t num_failures = 0;
     std::size_t num_rw_conflicts = 0;
     std::size_t num_ww_conflicts = 0;
+    std::size_t num_rmw_conflicts = 0; // conflicts of transactions with a read-modify-write
     std::size_t num_r_snapshot_misses = 0;
     std::size_t num_w_snapshot_misses = 0;
     std::size_t num_invalid_txs = 0;
     std::size_t num_canceled_txs = 0;
+    std::size_t num_bytes = 0;
     std::chrono::high_resolution_clock::time_point start;
     std::chrono::high_resolution_clock::time_point end;
+    std::vector<PhaseResult> phases;
 };
 
 struct BenchThreadArgs {
@@ -42,13 +58,84 @@ struct BenchThreadArgs {
     cpu_set_t cpu_set;
     ProgramArgs* pargs;
     kp_kv_master* master;
-    std::vector<KVPair>* pairs;
+    tools::dataset_t* pairs;
     tools::workload_t* workload;
-    std::size_t pos_begin;
-    std::size_t pos_end;
+    tools::workload_stream_t* stream;
+    std::vector<tools::workload_range_t> ranges; // one per phase
+    pthread_barrier_t* barrier;
     BenchThreadResult result;
 };
 
+/**
+ * Derives the value a read-modify-write writes back from the value it read.
+ * The size stays the same.
+ */
+void modify_value(std::string& value)
+{
+    if (!value.empty())
+        ++value.back();
+}
+
+/**
+ * Returns transaction i of the worker's stream, or of the loaded workload if
+ * it has none. A stream that cannot be read, e.g. because a position is not
+ * part of the data set, ends the benchmark like a workload that cannot be
+ * loaded.
+ */
+tools::workload_tx_t fetch_tx(tools::workload_stream_t* stream, const tools::workload_t& workload, std::size_t i)
+{
+    if (!stream)
+        return workload[i];
+    try {
+        return (*stream)[i];
+    }
+    catch (const std::runtime_error& e) {
+        std::cout << e.what() << std::endl;
+        std::_Exit(1);
+    }
+}
+
+/**
+ * Writes ranges of pairs for populate(), each in a single transaction of its
+ * own local store.
+ */
+class BatchWriter {
+public:
+    BatchWriter(kp_kv_master* master, const tools::dataset_t& pairs, std::size_t batch_size)
+        : pairs{pairs}
+    {
+        if (kp_kv_local_create(master, &local, batch_size ? batch_size : pairs.size(), false))
+            std::cout << "error: creating local store for populating failed!\n";
+    }
+    BatchWriter(const BatchWriter&) = delete;
+    BatchWriter& operator=(const BatchWriter&) = delete;
+    ~BatchWriter() { kp_kv_local_destroy(&local); }
+
+    bool operator()(std::size_t first, std::size_t last)
+    {
+        PM_START_TX();
+        for (std::size_t i = first; i < last; ++i) {
+            const auto [key, val] = pairs[i];
+            const auto rc = kp_local_put(local, pairs.cstr(key, key_buf), val.data(), val.size());
+            if (rc)
+                std::cout << "status code: " << rc << std::endl;
+        }
+
+        // 0 = success, 1 = conflict, -1 = error, 2 = empty commit
+        const auto rc = kp_local_commit(local, NULL);
+        if (rc == 0 || rc == 2) {
+            PM_END_TX();
+            return true;
+        }
+        return false;
+    }
+
+private:
+    const tools::dataset_t& pairs;
+    kp_kv_local* local = nullptr;
+    std::string key_buf;
+};
+
 void* worker_routine(void* arg)
 {
     BenchThreadArgs* worker_args = (BenchThreadArgs *) arg;
@@ -60,8 +147,8 @@ void* worker_routine(void* arg)
     const auto time_unit = prog_args->unit;
     const auto num_retries_max = prog_args->num_retries;
     const auto& workload = *worker_args->workload;
-    const auto pos_begin = worker_args->pos_begin;
-    const auto pos_end = worker_args->pos_end;
+    const auto stream = worker_args->stream;
+    const auto& ranges = worker_args->ranges;
 
     if (prog_args->verbose) {
         std::stringstream ss;
@@ -72,7 +159,10 @@ void* worker_routine(void* arg)
 
     if (prog_args->verbose) {
         std::stringstream ss;
-        ss << "worker " << id << " has workload range [" << pos_begin << "-" << pos_end << ")" << std::endl;
+        ss << "worker " << id << " has workload ranges";
+        for (const auto& range : ranges)
+            ss << " [" << range.first_tx << "-" << range.last_tx << ")";
+        ss << std::endl;
         std::cout << ss.str();
     }
 
@@ -87,15 +177,23 @@ void* worker_routine(void* arg)
 
     std::string result;
 
+    // Reusable buffer for null-terminating keys (unless the data set does)
+    std::string key_buf;
+
+    // Reusable buffer for the values read-modify-writes write back
+    std::string val_buf;
+
     // Counters
     std::size_t num_failures = 0;
     std::size_t num_rw_conflicts = 0;
     std::size_t num_ww_conflicts = 0;
+    std::size_t num_rmw_conflicts = 0;
     std::size_t num_r_snapshot_misses = 0;
     std::size_t num_w_snapshot_misses = 0;
     std::size_t num_invalid_txs = 0;
     std::size_t num_canceled_txs = 0;
     std::size_t num_retries = 0;
+    std::size_t num_bytes = 0;
 
     // ########################################################################
     // ## START ###############################################################
@@ -103,77 +201,136 @@ void* worker_routine(void* arg)
 
     const auto time_start = std::chrono::high_resolution_clock::now();
 
-    for (std::size_t step = pos_begin; step < pos_end; ) {
-        const auto& workload_tx = workload[step];
-
-        // begin transaction
-        PM_START_TX();
-
-        for (const auto& workload_cmd : workload_tx) {
-
-            // select pair
-            const auto& [key, val] = (*pairs)[workload_cmd.pos];
-
-            // perform operation
-            switch (workload_cmd.opcode) {
-            case tools::tx_opcode_t::Get:
-                {
-                    const char* key_ = key.c_str();
-                    char* val_;
-                    std::size_t size;
-                    rc = kp_local_get(local, key_, (void**)&val_, &size);
-                }
-                break;
-
-            case tools::tx_opcode_t::Put:
-                {
-                    const char* key_ = key.c_str();
-                    const char* val_ = val.c_str();
-                    const std::size_t size = val.size();
-                    rc = kp_local_put(local, key_, val_, size);
+    auto& phase_results = worker_args->result.phases;
+    phase_results.assign(ranges.size(), {});
+    for (std::size_t phase = 0; phase < ranges.size(); ++phase) {
+        const auto& range = ranges[phase];
+        auto& phase_result = phase_results[phase];
+
+        // Workers start each phase together, so that phases do not overlap
+        if (phase)
+            pthread_barrier_wait(worker_args->barrier);
+
+        const auto num_failures_before = num_failures;
+        const auto num_canceled_txs_before = num_canceled_txs;
+        phase_result.start = std::chrono::high_resolution_clock::now();
+
+        for (std::size_t step = range.first_tx; step < range.last_tx; ) {
+            const auto workload_tx = fetch_tx(stream, workload, step);
+
+            // payload bytes touched by this attempt: the key of every
+            // operation plus the values actually read or written
+            std::size_t tx_bytes = 0;
+            bool has_rmw = false;
+
+            // begin transaction
+            PM_START_TX();
+
+            for (const auto& workload_cmd : workload_tx) {
+
+                // select pair
+                const auto [key, val] = (*pairs)[workload_cmd.pos()];
+                const char* key_ = pairs->cstr(key, key_buf);
+                tx_bytes += key.size();
+
+                // perform operation
+                switch (workload_cmd.opcode()) {
+                case tools::tx_opcode_t::Get:
+                    {
+                        char* val_;
+                        std::size_t size;
+                        rc = kp_local_get(local, key_, (void**)&val_, &size);
+                        if (rc == 0)
+                            tx_bytes += size;
+                    }
+                    break;
+
+                case tools::tx_opcode_t::Put:
+                case tools::tx_opcode_t::Ins:
+                    {
+                        const char* val_ = val.data();
+                        const std::size_t size = val.size();
+                        tx_bytes += size;
+                        rc = kp_local_put(local, key_, val_, size);
+                    }
+                    break;
+
+                case tools::tx_opcode_t::Del:
+                    // 0 = success, 1 = not found, -1 = error
+                    rc = kp_local_delete_key(local, key_);
+                    if (rc == 1)
+                        ++num_w_snapshot_misses;
+                    break;
+
+                case tools::tx_opcode_t::Rmw:
+                    {
+                        // A pair missing from the store starts from its
+                        // value in the data set
+                        has_rmw = true;
+                        char* val_;
+                        std::size_t size;
+                        if (kp_local_get(local, key_, (void**)&val_, &size) == 0) {
+                            val_buf.assign(val_, size);
+                            tx_bytes += size;
+                        }
+                        else {
+                            val_buf.assign(val.data(), val.size());
+                        }
+                        modify_value(val_buf);
+                        tx_bytes += val_buf.size();
+                        rc = kp_local_put(local, key_, val_buf.data(), val_buf.size());
+                    }
+                    break;
+
+                default:
+                    throw std::runtime_error("error: unexpected operation type");
                 }
-                break;
-
-            default:
-                throw std::runtime_error("error: unexpected operation type");
             }
-        }
 
-        // commit transaction
-        rc = kp_local_commit(local, NULL);
-        if (rc == 1) {
-            if (prog_args->verbose) {
-                std::stringstream ss;
-                ss << "error: conflict during commit of transaction #" << step << " on thread " << id << " (rc=" << rc << ")" << "!\n";
-                std::cout << ss.str();
-            }
-            ++num_failures;
-            ++num_ww_conflicts;
-            if (num_retries_max) {
-                if (num_retries < num_retries_max) {
-                    ++num_retries;
+            // commit transaction
+            rc = kp_local_commit(local, NULL);
+            if (rc == 1) {
+                if (prog_args->verbose) {
+                    std::stringstream ss;
+                    ss << "error: conflict during commit of transaction #" << step << " on thread " << id << " (rc=" << rc << ")" << "!\n";
+                    std::cout << ss.str();
+                }
+                ++num_failures;
+                ++num_ww_conflicts;
+                if (has_rmw)
+                    ++num_rmw_conflicts;
+                if (num_retries_max) {
+                    if (num_retries < num_retries_max) {
+                        ++num_retries;
+                    }
+                    else {
+                        num_retries = 0;
+                        ++num_canceled_txs;
+                        ++step;
+                    }
                 }
                 else {
-                    num_retries = 0;
                     ++num_canceled_txs;
                     ++step;
                 }
             }
-            else {
-                ++num_canceled_txs;
+            else if (rc == -1) {
+                std::stringstream ss;
+                ss << "error: error during commit of transaction #" << step << " on thread " << id << " (rc=" << rc << ")" << "!\n";
+                std::cout << ss.str();
+                exit(1);
+            }
+            else { // 0 = success, 2 = empty commit (read only tx)
+                PM_END_TX();
+                num_bytes += tx_bytes;
                 ++step;
             }
         }
-        else if (rc == -1) {
-            std::stringstream ss;
-            ss << "error: error during commit of transaction #" << step << " on thread " << id << " (rc=" << rc << ")" << "!\n";
-            std::cout << ss.str();
-            exit(1);
-        }
-        else { // 0 = success, 2 = empty commit (read only tx)
-            PM_END_TX();
-            ++step;
-        }
+
+        phase_result.end = std::chrono::high_resolution_clock::now();
+        phase_result.num_txs = range.last_tx - range.first_tx;
+        phase_result.num_failures = num_failures - num_failures_before;
+        phase_result.num_canceled_txs = num_canceled_txs - num_canceled_txs_before;
     }
 
     const auto time_end = std::chrono::high_resolution_clock::now();
@@ -186,9 +343,11 @@ void* worker_routine(void* arg)
     worker_args->result.num_canceled_txs = num_canceled_txs;
     worker_args->result.num_rw_conflicts = num_rw_conflicts;
     worker_args->result.num_ww_conflicts = num_ww_conflicts;
+    worker_args->result.num_rmw_conflicts = num_rmw_conflicts;
     worker_args->result.num_r_snapshot_misses = num_r_snapshot_misses;
     worker_args->result.num_w_snapshot_misses = num_w_snapshot_misses;
     worker_args->result.num_invalid_txs = num_invalid_txs;
+    worker_args->result.num_bytes = num_bytes;
     worker_args->result.start = time_start;
     worker_args->result.end = time_end;
 
@@ -198,20 +357,58 @@ void* worker_routine(void* arg)
 int run(ProgramArgs* pargs)
 {
     // load sample data
-    std::vector<KVPair> pairs;
-    if (read_pairs(pargs->data_file, pairs)) {
+    tools::dataset_t pairs;
+    if (tools::loadDataset(pargs->data_file, pairs)) {
         std::cout << "error: could not read pairs from file " << pargs->data_file << "!\n";
         return 1;
     }
+    if (pargs->arena && tools::compactDataset(pairs, pargs->huge_pages)) {
+        std::cout << "error: could not copy pairs into arena!\n";
+        return 1;
+    }
 
-    // load workload
+    // load workload, or only its size if it is streamed or generated
     tools::workload_t workload;
-    if (tools::parseWorkload(pargs->workload_file, workload)) {
-        std::cout << "error: could not read workload from file " << pargs->workload_file << "!\n";
-        return 1;
+    tools::tx_generator_t generator;
+    std::size_t workload_size = 0;
+    std::vector<std::uint64_t> phase_starts;
+    const bool generate = !pargs->tx_profile_file.empty();
+    if (generate) {
+        tools::tx_phases_t phases;
+        if (tools::parseTransactionPhases(pargs->tx_profile_file, phases)) {
+            std::cout << "error: could not read transaction profiles from file " << pargs->tx_profile_file << "!\n";
+            return 1;
+        }
+        if (generator.init(phases, pairs.size(), pargs->tx_length_min, pargs->tx_length_max, pargs->seed,
+                pargs->num_loaded))
+            return 1;
+        workload_size = generator.scheduleSize() ? generator.scheduleSize() : pargs->num_txs;
+        phase_starts = generator.phaseStarts();
+        if (pargs->partitioned && generator.partition(pargs->num_threads, pargs->cross_prob, workload_size))
+            return 1;
+        std::cout << "seed=" << pargs->seed << std::endl;
+    }
+    else if (pargs->stream) {
+        tools::workload_header_t header;
+        if (tools::readWorkloadHeader(pargs->workload_file, header)
+                || tools::readWorkloadPhases(pargs->workload_file, phase_starts)) {
+            std::cout << "error: could not stream workload from file " << pargs->workload_file << "!\n";
+            return 1;
+        }
+        workload_size = header.num_txs;
     }
+    else {
+        if (tools::parseWorkload(pargs->workload_file, workload, pairs.size())) {
+            std::cout << "error: could not read workload from file " << pargs->workload_file << "!\n";
+            return 1;
+        }
+        workload_size = workload.size();
+        phase_starts = workload.phaseStarts();
+    }
+    if (phase_starts.empty())
+        phase_starts.push_back(0);
 
-    if (workload.size() < pargs->num_threads) {
+    if (workload_size < pargs->num_threads) {
         std::cout << "error: too many threads for given size of workload (must be less or equal)!\n";
         return 1;
     }
@@ -245,21 +442,10 @@ int run(ProgramArgs* pargs)
     if (pargs->verbose)
         std::cout << "populating..." << std::endl;
 
-    if (pairs.size()) {
-        kp_kv_local *local;
-        int rc = kp_kv_local_create(master, &local, pairs.size(), false);
-
-        PM_START_TX();
-        for (auto [key, value] : pairs) {
-            rc = kp_local_put(local, key.c_str(), value.c_str(), value.size());
-            if (rc)
-                std::cout << "status code: " << rc << std::endl;
-        }
-        rc = kp_local_commit(local, NULL);
-        PM_END_TX();
-
-        kp_kv_local_destroy(&local);
-    }
+    const auto num_loaded = pargs->num_loaded ? pargs->num_loaded : pairs.size();
+    auto populate_result = populate(pairs, num_loaded, pargs->populate_threads, pargs->populate_batch,
+            [&]() { return BatchWriter{master, pairs, pargs->populate_batch}; });
+    print_populate_result(populate_result, pargs->unit);
 
     // ########################################################################
     // Run benchmark
@@ -279,16 +465,60 @@ int run(ProgramArgs* pargs)
         std::cout << "logical cpus: " << (num_cpus * pargs->smt_ratio) << std::endl;
     }
 
-    // Compute absolute number of steps performed by each worker
-    const std::size_t num_steps_each = workload.size() / pargs->num_threads;
-
-    // Compute remainder if workload size is not evenly divisible by number of
-    // threads. This value is reduced as it is distributed over all threads in
-    // a round-robin manner to compensate for the gap
-    std::size_t num_steps_carry = workload.size() % pargs->num_threads;
+    // Each phase is split into one contiguous range per worker, the first
+    // phase_size % num_threads workers getting one transaction more. Workers
+    // run their ranges phase by phase.
+    //
+    // Generated inserts and deletes of each range start after those of the
+    // ranges before, so they are counted up front. A worker may still read a
+    // pair another worker has yet to insert or has already deleted, which
+    // counts as a snapshot miss.
+    tools::tx_cursor_t cursor;
+    for (std::size_t p = 0; p < phase_starts.size(); ++p) {
+        const auto phase_first = phase_starts[p];
+        const auto phase_size = (p + 1 < phase_starts.size() ? phase_starts[p + 1] : workload_size) - phase_first;
+        for (std::size_t i = 0; i < pargs->num_threads; ++i) {
+            tools::workload_range_t range;
+            range.first_tx = phase_first + tools::partBegin(phase_size, pargs->num_threads, i);
+            range.last_tx = phase_first + tools::partBegin(phase_size, pargs->num_threads, i + 1);
+            range.cursor = cursor;
+            if (generate)
+                cursor += generator.countKeyChanges(range.first_tx, range.last_tx);
+            thread_args[i].ranges.push_back(range);
+        }
+    }
+    if (generate && generator.checkKeyChanges(cursor, pairs.size()))
+        return 1;
 
-    // Current starting step
-    std::size_t step = 0;
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, nullptr, pargs->num_threads);
+
+    // One stream per worker, each starting to read or generate ahead as soon
+    // as it is opened. The clock starts once the first block of every stream
+    // is ready, so that opening, reading or generating it is not timed.
+    const bool use_streams = pargs->stream || generate;
+    std::vector<tools::workload_stream_t> streams(use_streams ? pargs->num_threads : 0);
+    for (std::size_t i = 0; i < streams.size(); ++i) {
+        if (generate) {
+            if (streams[i].open(generator, thread_args[i].ranges)) {
+                std::cout << "error: could not generate workload!\n";
+                return 1;
+            }
+        }
+        else if (streams[i].open(pargs->workload_file, pairs.size(), thread_args[i].ranges)) {
+            std::cout << "error: could not stream workload from file " << pargs->workload_file << "!\n";
+            return 1;
+        }
+    }
+    for (auto& stream : streams) {
+        if (stream.waitReady()) {
+            if (generate)
+                std::cout << "error: could not generate workload!\n";
+            else
+                std::cout << "error: could not stream workload from file " << pargs->workload_file << "!\n";
+            return 1;
+        }
+    }
 
     const auto time_bench_start = std::chrono::high_resolution_clock::now();
 
@@ -299,15 +529,9 @@ int run(ProgramArgs* pargs)
         thread_args[i].pairs = &pairs;
         thread_args[i].workload = &workload;
         thread_args[i].id = i;
+        thread_args[i].barrier = &barrier;
 
-        // Compute and assign workload range for the current worker
-        thread_args[i].pos_begin = step;
-        thread_args[i].pos_end = step + num_steps_each;
-        if (num_steps_carry) {
-            ++thread_args[i].pos_end;
-            --num_steps_carry;
-        }
-        step = thread_args[i].pos_end;
+        thread_args[i].stream = use_streams ? &streams[i] : nullptr;
 
         /* Create Attributes */
         rc = pthread_attr_init(&attr);
@@ -351,10 +575,12 @@ int run(ProgramArgs* pargs)
     std::size_t num_failures = 0;
     std::size_t num_rw_conflicts = 0;
     std::size_t num_ww_conflicts = 0;
+    std::size_t num_rmw_conflicts = 0;
     std::size_t num_r_snapshot_misses = 0;
     std::size_t num_w_snapshot_misses = 0;
     std::size_t num_invalid_txs = 0;
     std::size_t num_canceled_txs = 0;
+    std::size_t num_bytes = 0;
     for (std::size_t i=0; i<pargs->num_threads; ++i) {
         if (pargs->verbose) {
             std::cout << "----------------------------------------\n";
@@ -367,6 +593,8 @@ int run(ProgramArgs* pargs)
             // std::cout << "invalid txs   = " << thread_args[i].result.num_invalid_txs << std::endl;
             std::cout << "w/w conflicts = " << (thread_args[i].result.num_ww_conflicts + thread_args[i].result.num_w_snapshot_misses) << std::endl;
             std::cout << "r/w conflicts = " << thread_args[i].result.num_rw_conflicts << std::endl;
+            std::cout << "rmw conflicts = " << thread_args[i].result.num_rmw_conflicts << std::endl;
+            std::cout << "bytes         = " << thread_args[i].result.num_bytes << std::endl;
             std::cout << "duration      = " << convert_duration(
                 thread_args[i].result.end - thread_args[i].result.start,
                 time_unit) << time_unit << std::endl;
@@ -374,10 +602,12 @@ int run(ProgramArgs* pargs)
         num_failures += thread_args[i].result.num_failures;
         num_rw_conflicts += thread_args[i].result.num_rw_conflicts;
         num_ww_conflicts += thread_args[i].result.num_ww_conflicts;
+        num_rmw_conflicts += thread_args[i].result.num_rmw_conflicts;
         num_r_snapshot_misses += thread_args[i].result.num_r_snapshot_misses;
         num_w_snapshot_misses += thread_args[i].result.num_w_snapshot_misses;
         num_invalid_txs += thread_args[i].result.num_invalid_txs;
         num_canceled_txs += thread_args[i].result.num_canceled_txs;
+        num_bytes += thread_args[i].result.num_bytes;
     }
 
     if (pargs->verbose) {
@@ -394,7 +624,35 @@ int run(ProgramArgs* pargs)
     std::cout << "invalid txs=" << num_invalid_txs << std::endl;
     std::cout << "ww conflicts=" << (num_ww_conflicts + num_w_snapshot_misses) << std::endl;
     std::cout << "rw conflicts=" << num_rw_conflicts << std::endl;
-    std::cout << "throughput=" << ((workload.size() - num_canceled_txs) / duration) << "/" << time_unit << std::endl;
+    std::cout << "rmw conflicts=" << num_rmw_conflicts << std::endl;
+    std::cout << "throughput=" << ((workload_size - num_canceled_txs) / duration) << "/" << time_unit << std::endl;
+    std::cout << "bandwidth=" << (num_bytes / duration) << "B/" << time_unit << std::endl;
+
+    // A phase lasts from the first worker starting it to the last one
+    // finishing it
+    for (std::size_t p = 0; phase_starts.size() > 1 && p < phase_starts.size(); ++p) {
+        auto phase_start = thread_args[0].result.phases[p].start;
+        auto phase_end = thread_args[0].result.phases[p].end;
+        std::size_t phase_txs = 0;
+        std::size_t phase_failures = 0;
+        std::size_t phase_canceled_txs = 0;
+        for (std::size_t i = 0; i < pargs->num_threads; ++i) {
+            const auto& phase_result = thread_args[i].result.phases[p];
+            phase_start = std::min(phase_start, phase_result.start);
+            phase_end = std::max(phase_end, phase_result.end);
+            phase_txs += phase_result.num_txs;
+            phase_failures += phase_result.num_failures;
+            phase_canceled_txs += phase_result.num_canceled_txs;
+        }
+        const auto phase_duration = convert_duration(phase_end - phase_start, time_unit);
+        const auto phase_attempts = phase_txs - phase_canceled_txs + phase_failures;
+        std::cout << "phase " << p << " txs=" << phase_txs << std::endl;
+        std::cout << "phase " << p << " time=" << phase_duration << ' ' << time_unit << std::endl;
+        std::cout << "phase " << p << " failures=" << phase_failures << std::endl;
+        std::cout << "phase " << p << " canceled=" << phase_canceled_txs << std::endl;
+        std::cout << "phase " << p << " abort rate=" << (phase_attempts ? double(phase_failures) / phase_attempts : 0.0) << std::endl;
+        std::cout << "phase " << p << " throughput=" << ((phase_txs - phase_canceled_txs) / phase_duration) << "/" << time_unit << std::endl;
+    }
 
     // ########################################################################
     // Cleanup
@@ -402,6 +660,8 @@ int run(ProgramArgs* pargs)
 
     kp_kv_master_destroy(master);
 
+    pthread_barrier_destroy(&barrier);
+
     rc = pthread_attr_destroy(&attr);
     if(rc != 0)
         std::printf("pthread_attr_destroy() returned error=%d\n", rc);
@@ -4,12 +4,15 @@
 #include <fstream>  // std::ifstream
 #include <chrono>   // std::chrono::high_resolution_clock, std::chrono::duration
 #include <cmath>    // std::ceil, std::log10
-#include <algorithm>// std::min_element, std::max_element
+#include <algorithm>// std::min_element, std::max_element, std::shuffle
+#include <numeric>  // std::iota
 #include <random>   // std::random_device, std::uniform_int_distribution
 #include <stdexcept>// std::invalid_argument
 
 #include "midas.hpp"
 
+#include "dataset.hpp"
+
 #include <getopt.h> // getopt_long
 
 //#define _GNU_SOURCE
@@ -26,13 +29,13 @@ enum {
     CPU_OFFSET = 0
 };
 
-using KVPair = std::pair<std::string, std::string>;
-
 struct ProgramArgs {
     std::string opcode;
     std::string data_file;
     std::size_t num_repeats = 1000;
     std::string unit = "s";
+    bool arena = false;
+    bool huge_pages = false;
     bool verbose = false;
 };
 
@@ -40,7 +43,7 @@ struct BenchThreadArgs {
     cpu_set_t cpu_set;
     ProgramArgs* pargs;
     midas::Store* store;
-    std::vector<KVPair>* pairs;
+    tools::dataset_t* pairs;
 };
 
 /**
@@ -60,38 +63,6 @@ __attribute__((always_inline)) inline void DoNotOptimize(const T &value) {
       asm volatile("" : "+m"(const_cast<T &>(value)));
 }
 
-std::vector<KVPair> fetch_data(const std::string& path)
-{
-    std::ifstream ifs{path};
-    if (!ifs.is_open())
-        return {};
-
-    std::string line;
-    // std::getline(ifs, line);
-    // std::size_t key_size = std::stoi(line);
-    // std::getline(ifs, line);
-    // std::size_t val_size = std::stoi(line);
-    // std::getline(ifs, line);
-    // std::size_t num_pairs = std::stoi(line);
-
-    std::vector<KVPair> pairs;
-    while (std::getline(ifs, line)) {
-        if (!line.empty()) {
-            auto pos_delim = line.find(';');
-            if (pos_delim != std::string::npos) {
-                pairs.emplace_back(
-                    line.substr(0, pos_delim), // get chars before delimiter
-                    line.substr(pos_delim + 1) // get chars after delimiter
-                );
-            }
-            else {
-                throw std::invalid_argument("error: missing delimiter (;) in line");
-            }
-        }
-    }
-    return pairs;
-}
-
 void measure_populated_store(BenchThreadArgs* thread_args, std::vector<std::chrono::duration<double>>& latencies)
 {
     midas::Store* store = thread_args->store;
@@ -104,13 +75,15 @@ void measure_populated_store(BenchThreadArgs* thread_args, std::vector<std::chro
 
     std::random_device rand_dev;
     std::mt19937 rng(rand_dev());
-    std::uniform_int_distribution<> dist(0, pairs.size() - 1);
+    std::uniform_int_distribution<std::size_t> dist(0, pairs.size() - 1);
+
+    std::string key;
+    std::string val;
 
     if (opcode == "get") {
         auto tx = store->begin();
         for (size_t i=0; i<num_repeats; ++i) {
-            const auto& [key, val] = pairs[dist(rng)];
-            (void)val;
+            key = pairs[dist(rng)].first;
             if (verbose) {
                 std::cout << "get(\n";
                 std::cout << "\tkey = " << key << '\n';
@@ -132,7 +105,9 @@ void measure_populated_store(BenchThreadArgs* thread_args, std::vector<std::chro
     else if (opcode == "put") {
         auto tx = store->begin();
         for (size_t i=0; i<num_repeats; ++i) {
-            const auto& [key, val] = pairs[dist(rng)];
+            const auto pair = pairs[dist(rng)];
+            key = pair.first;
+            val = pair.second;
             if (verbose) {
                 std::cout << "put(\n";
                 std::cout << "\tkey = " << key << '\n';
@@ -151,10 +126,54 @@ void measure_populated_store(BenchThreadArgs* thread_args, std::vector<std::chro
         store->commit(tx);
     }
     else if (opcode == "ins") {
-        // TODO not really required (not used in throughput benchmark)
+        // The last num_repeats pairs are not populated, so each insert
+        // writes a key the store does not hold yet
+        auto tx = store->begin();
+        for (size_t i=pairs.size() - num_repeats; i<pairs.size(); ++i) {
+            const auto pair = pairs[i];
+            key = pair.first;
+            val = pair.second;
+            if (verbose) {
+                std::cout << "ins(\n";
+                std::cout << "\tkey = " << key << '\n';
+                std::cout << "\tval = " << val << '\n';
+                std::cout << ")\n";
+            }
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            DoNotOptimize(key);
+            const auto rc = store->write(tx, key, val);
+            DoNotOptimize(rc);
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            latencies.emplace_back(end - start);
+        }
+        store->commit(tx);
     }
     else if (opcode == "del") {
-        // TODO not really required (not used in throughput benchmark)
+        // Each delete removes another key
+        std::vector<std::size_t> order(pairs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+
+        auto tx = store->begin();
+        for (size_t i=0; i<num_repeats; ++i) {
+            key = pairs[order[i]].first;
+            if (verbose) {
+                std::cout << "del(\n";
+                std::cout << "\tkey = " << key << '\n';
+                std::cout << ")\n";
+            }
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            DoNotOptimize(key);
+            const auto rc = store->drop(tx, key);
+            DoNotOptimize(rc);
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            latencies.emplace_back(end - start);
+        }
+        store->commit(tx);
     }
 }
 
@@ -236,9 +255,12 @@ void* latency_benchmark(void* arg)
     auto store = thread_args->store;
     auto& pairs = *thread_args->pairs;
     if (pairs.size()) {
+        // Pairs to be inserted are left out
+        const auto num_populated = prog_args->opcode == "ins" ? pairs.size() - prog_args->num_repeats : pairs.size();
         auto tx = store->begin();
-        for (auto [key, value] : pairs) {
-            store->write(tx, key, value);
+        for (std::size_t i = 0; i < num_populated; ++i) {
+            const auto [key, value] = pairs[i];
+            store->write(tx, std::string{key}, std::string{value});
         }
         store->commit(tx);
     }
@@ -270,9 +292,20 @@ void* latency_benchmark(void* arg)
 
 int run(ProgramArgs* pargs)
 {
-    std::vector<KVPair> pairs;
-    if (!pargs->data_file.empty())
-        pairs = fetch_data(pargs->data_file);
+    tools::dataset_t pairs;
+    if (!pargs->data_file.empty() && tools::loadDataset(pargs->data_file, pairs)) {
+        std::cout << "error: could not read pairs from file " << pargs->data_file << "!\n";
+        return 0;
+    }
+    if (pargs->arena && tools::compactDataset(pairs, pargs->huge_pages)) {
+        std::cout << "error: could not copy pairs into arena!\n";
+        return 0;
+    }
+    if ((pargs->opcode == "ins" || pargs->opcode == "del") && pargs->num_repeats > pairs.size()) {
+        std::cout << "error: cannot " << pargs->opcode << " " << pargs->num_repeats << " of "
+            << pairs.size() << " pairs!\n";
+        return 0;
+    }
 
     if (pargs->verbose)
         std::cout << "initializing store..." << std::endl;
@@ -355,16 +388,21 @@ void usage()
     std::cout << "\tput\n";
     std::cout << "\t\tUpdate.\n";
     std::cout << "\tins\n";
-    std::cout << "\t\tInsertion (currently not supported).\n";
+    std::cout << "\t\tInsertion of keys left out when populating.\n";
     std::cout << "\tget\n";
     std::cout << "\t\tRetrieval.\n";
     std::cout << "\tdel\n";
-    std::cout << "\t\tDeletion (currently not supported).\n";
+    std::cout << "\t\tDeletion of distinct keys.\n";
     std::cout << "\nOPTIONS\n";
     std::cout << "\t-p, --populate FILE\n";
     std::cout << "\t\tPopulates the database with data from the specified file.\n";
+    std::cout << "\t\tAlternatively, proc:NUM_PAIRS:KEY_SIZE:VAL_SIZE[:SEED] derives pairs on the fly without a file.\n";
     std::cout << "\t-r, --repeats NUM\n";
     std::cout << "\t\tSets the number of repetitions for the given operation (default = 1000).\n";
+    std::cout << "\t-a, --arena\n";
+    std::cout << "\t\tCopies the sample data into a contiguous arena before populating.\n";
+    std::cout << "\t-g, --huge-pages\n";
+    std::cout << "\t\tLike --arena but backs the arena with transparent huge pages.\n";
     std::cout << "\t-u, --unit UNIT\n";
     std::cout << "\t\tSets the time unit of used when printing results. Can be one of {s | ms | us | ns} (default = s).\n";
     std::cout << "\t-v, --verbose\n";
@@ -389,13 +427,15 @@ void parse_args(int argc, char* argv[], ProgramArgs& pargs)
         { "repeats"  , required_argument , NULL , 'r' },
         { "populate" , required_argument , NULL , 'p' },
         { "unit"     , required_argument , NULL , 'u' },
+        { "arena"    , no_argument       , NULL , 'a' },
+        { "huge-pages", no_argument      , NULL , 'g' },
         { "verbose"  , no_argument       , NULL , 'v' },
         { "help"     , no_argument       , NULL , 'h' },
         { NULL       , 0                 , NULL , 0 }
     };
 
     char ch;
-    while ((ch = getopt_long(argc, argv, "r:p:u:v", longopts, NULL)) != -1) {
+    while ((ch = getopt_long(argc, argv, "r:p:u:agv", longopts, NULL)) != -1) {
         switch (ch) {
         case 'r':
             pargs.num_repeats = std::stoll(optarg);
@@ -409,6 +449,15 @@ void parse_args(int argc, char* argv[], ProgramArgs& pargs)
             pargs.unit = optarg;
             break;
 
+        case 'a':
+            pargs.arena = true;
+            break;
+
+        case 'g':
+            pargs.arena = true;
+            pargs.huge_pages = true;
+            break;
+
         case 'v':
             pargs.verbose = true;
             break;
@@ -434,6 +483,8 @@ void print_args(ProgramArgs& pargs)
     std::cout << "repeats : " << pargs.num_repeats << std::endl;
     std::cout << "datafile: " << pargs.data_file << std::endl;
     std::cout << "unit    : " << pargs.unit << std::endl;
+    std::cout << "arena   : " << pargs.arena << std::endl;
+    std::cout << "hugepage: " << pargs.huge_pages << std::endl;
     std::cout << "verbose : " << pargs.verbose << std::endl;
 }
 
@@ -0,0 +1,227 @@
+#include <iostream> // std::cout, std::endl
+#include <string>   // std::string
+#include <cstdint>  // std::uint64_t
+
+#include <sys/resource.h> // getrusage
+#include <unistd.h>       // unlink
+
+#include "midas.hpp"
+#include <libpmemobj.h> // pmemobj_ctl_get, pmemobj_ctl_set
+
+#include "dataset.hpp"
+#include "duration.hpp"
+#include "populate.hpp"
+
+#include <getopt.h> // getopt_long
+
+namespace bench {
+
+const std::string STORE_FILE = "/dev/shm/nvdimm_midas";
+const std::size_t POOL_SIZE = 2048ULL * 1024 * 1024;
+
+struct ProgramArgs {
+    std::string data_file;
+    std::size_t num_threads = 1;
+    std::size_t batch_size = 0;
+    std::string unit = "s";
+    bool arena = false;
+    bool huge_pages = false;
+    bool verbose = false;
+};
+
+/**
+ * Returns a batch writer for populate(), which writes a range of pairs in a
+ * single transaction.
+ */
+auto make_batch_writer(midas::Store& store, const tools::dataset_t& pairs)
+{
+    return [&store, &pairs]() {
+        return [&store, &pairs, key_buf = std::string{}, val_buf = std::string{}]
+                (std::size_t first, std::size_t last) mutable {
+            auto tx = store.begin();
+            for (std::size_t i = first; i < last; ++i) {
+                const auto [key, val] = pairs[i];
+                key_buf.assign(key.data(), key.size());
+                val_buf.assign(val.data(), val.size());
+                store.write(tx, key_buf, val_buf);
+            }
+            if (tx->getStatus() == midas::Transaction::FAILED)
+                return false;
+            return store.commit(tx) == midas::Store::OK;
+        };
+    };
+}
+
+int run(ProgramArgs* pargs)
+{
+    tools::dataset_t pairs;
+    if (tools::loadDataset(pargs->data_file, pairs)) {
+        std::cout << "error: could not read pairs from file " << pargs->data_file << "!\n";
+        return 1;
+    }
+    if (pargs->arena && tools::compactDataset(pairs, pargs->huge_pages)) {
+        std::cout << "error: could not copy pairs into arena!\n";
+        return 1;
+    }
+
+    if (pargs->verbose)
+        std::cout << "initializing store..." << std::endl;
+
+    // Always load into an empty pool
+    ::unlink(STORE_FILE.c_str());
+
+    midas::pop_type pop;
+    if (!midas::init(pop, STORE_FILE, POOL_SIZE)) {
+        std::cout << "error: could not open file <" << STORE_FILE << ">!\n";
+        return 1;
+    }
+    midas::Store store{pop};
+
+    // Heap statistics are needed to tell how much of the pool is in use
+    int stats_enabled = 1;
+    pmemobj_ctl_set(pop.handle(), "stats.enabled", &stats_enabled);
+    std::uint64_t allocated_start = 0;
+    pmemobj_ctl_get(pop.handle(), "stats.heap.curr_allocated", &allocated_start);
+
+    if (pargs->verbose)
+        std::cout << "loading..." << std::endl;
+
+    auto result = populate(pairs, pargs->num_threads, pargs->batch_size,
+            make_batch_writer(store, pairs));
+
+    std::cout << "threads=" << pargs->num_threads << std::endl;
+    std::cout << "batch=" << pargs->batch_size << std::endl;
+    print_populate_result(result, pargs->unit);
+
+    std::uint64_t allocated_end = 0;
+    if (pmemobj_ctl_get(pop.handle(), "stats.heap.curr_allocated", &allocated_end) == 0)
+        std::cout << "pool bytes=" << (allocated_end - allocated_start) << std::endl;
+    else
+        std::cout << "pool bytes=n/a" << std::endl;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "peak rss=" << (usage.ru_maxrss * 1024ULL) << std::endl;
+
+    pop.close();
+    return 0;
+}
+
+void usage()
+{
+    ProgramArgs pargs;
+    std::cout << "NAME\n";
+    std::cout << "\tload - determine how fast sample data is loaded into an empty store\n";
+    std::cout << "\nSYNOPSIS\n";
+    std::cout << "\tload options\n";
+    std::cout << "\nOPTIONS\n";
+    std::cout << "\t-d, --data FILE\n";
+    std::cout << "\t\tPath to a file containing sample data pairs in CSV or binary format. This parameter is required.\n";
+    std::cout << "\t\tAlternatively, proc:NUM_PAIRS:KEY_SIZE:VAL_SIZE[:SEED] derives pairs on the fly without a file.\n";
+    std::cout << "\t-t, --num-threads INT\n";
+    std::cout << "\t\tThe number of threads writing pairs. (default = " << pargs.num_threads << ")\n";
+    std::cout << "\t-b, --batch INT\n";
+    std::cout << "\t\tThe number of pairs written per transaction.\n";
+    std::cout << "\t\t0 writes all pairs of a thread in a single transaction. (default = " << pargs.batch_size << ")\n";
+    std::cout << "\t-a, --arena\n";
+    std::cout << "\t\tCopies the sample data into a contiguous arena before loading.\n";
+    std::cout << "\t-g, --huge-pages\n";
+    std::cout << "\t\tLike --arena but backs the arena with transparent huge pages.\n";
+    std::cout << "\t-u, --unit UNIT\n";
+    std::cout << "\t\tSets the time unit of used when printing results. Can be one of {s | ms | us | ns} (default = " << pargs.unit << ").\n";
+    std::cout << "\t-v, --verbose\n";
+    std::cout << "\t\tPrint additional info.\n";
+    std::cout << "\t-h, --help\n";
+    std::cout << "\t\tShow this help text.\n";
+}
+
+void parse_args(int argc, char* argv[], ProgramArgs& pargs)
+{
+    static struct option longopts[] = {
+        { "data"       , required_argument , NULL , 'd' },
+        { "num-threads", required_argument , NULL , 't' },
+        { "batch"      , required_argument , NULL , 'b' },
+        { "unit"       , required_argument , NULL , 'u' },
+        { "arena"      , no_argument       , NULL , 'a' },
+        { "huge-pages" , no_argument       , NULL , 'g' },
+        { "verbose"    , no_argument       , NULL , 'v' },
+        { "help"       , no_argument       , NULL , 'h' },
+        { NULL         , 0                 , NULL , 0 }
+    };
+
+    char ch;
+    while ((ch = getopt_long(argc, argv, "d:t:b:u:aghv", longopts, NULL)) != -1) {
+        switch (ch) {
+        case 'd':
+            pargs.data_file = optarg;
+            break;
+
+        case 't':
+            pargs.num_threads = std::stoull(optarg);
+            break;
+
+        case 'b':
+            pargs.batch_size = std::stoull(optarg);
+            break;
+
+        case 'u':
+            pargs.unit = optarg;
+            break;
+
+        case 'a':
+            pargs.arena = true;
+            break;
+
+        case 'g':
+            pargs.arena = true;
+            pargs.huge_pages = true;
+            break;
+
+        case 'v':
+            pargs.verbose = true;
+            break;
+
+        case 'h':
+        default:
+            usage();
+            exit(0);
+        }
+    }
+}
+
+bool validate_args(ProgramArgs& pargs)
+{
+    if (pargs.data_file.empty()) {
+        std::cout << "error: no sample data provided (see option -d)\n";
+        return false;
+    }
+    else if (pargs.num_threads < 1) {
+        std::cout << "error: loading with less than 1 thread is not possible (see option -t)\n";
+        return false;
+    }
+    else if (pargs.unit != "s" && pargs.unit != "ms" && pargs.unit != "us" && pargs.unit != "ns") {
+        std::cout << "error: invalid time unit (see option -u)\n";
+        return false;
+    }
+    return true;
+}
+
+} // end namespace bench
+
+int main(int argc, char* argv[])
+{
+    using namespace bench;
+
+    if (argc < 2) {
+        usage();
+        exit(0);
+    }
+
+    ProgramArgs pargs;
+    parse_args(argc, argv, pargs);
+    if (!validate_args(pargs)) {
+        usage();
+        return 1;
+    }
+    return run(&pargs);
+}
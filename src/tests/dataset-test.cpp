@@ -0,0 +1,25 @@
+#include <string>
+#include <iostream>
+
+#include "dataset.hpp"
+
+int main(int argc, char* argv[])
+{
+    using namespace bench::tools;
+
+    if (argc < 2)
+        return 0;
+
+    const std::string filePath = argv[1];
+    dataset_t data;
+    if (loadDataset(filePath, data))
+        std::cout << "error: loading failed!\n";
+
+    std::printf("num_pairs = %zu\n", data.size());
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        const auto [key, val] = data[i];
+        std::cout << "#" << i << " [key_size=" << key.size() << ", val_size=" << val.size() << "] ";
+        std::cout << key << " -> " << val << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <string>
+#include <iostream>
+
+#include "tx-gen.hpp"
+
+using namespace bench::tools;
+
+static bool sameWorkload(const workload_t& a, const workload_t& b)
+{
+    return a.commands().size() == b.commands().size()
+        && std::equal(a.commands().begin(), a.commands().end(), b.commands().begin(),
+                [](const workload_cmd_t& x, const workload_cmd_t& y) {
+                    return x.opcode() == y.opcode() && x.pos() == y.pos();
+                })
+        && a.txOffsets() == b.txOffsets();
+}
+
+/**
+ * Generates transactions [first, last) split among 1 to 8 threads the way
+ * workload-gen and the scaling drivers do, and checks that the result does
+ * not depend on the number of threads.
+ */
+static int testThreadCounts(const char* name, const tx_generator_t& generator,
+        std::uint64_t first, std::uint64_t last)
+{
+    workload_t expected;
+    generator.generate(first, last, expected, generator.countKeyChanges(0, first));
+
+    for (std::size_t num_threads = 2; num_threads <= 8; ++num_threads) {
+        workload_t work;
+        for (std::size_t t = 0; t < num_threads; ++t) {
+            const auto begin = first + partBegin(last - first, num_threads, t);
+            const auto end = first + partBegin(last - first, num_threads, t + 1);
+            workload_t part;
+            generator.generate(begin, end, part, generator.countKeyChanges(0, begin));
+            work.append(part);
+        }
+        if (!sameWorkload(expected, work)) {
+            std::cout << "error: " << name << " differs with " << num_threads << " threads\n";
+            return 1;
+        }
+    }
+    std::cout << name << " ok\n";
+    return 0;
+}
+
+/**
+ * Sets up a generator from a profile or schedule file of assets/profiles.
+ */
+static int initGenerator(tx_generator_t& generator, const std::string& fileName,
+        std::size_t num_pairs, std::size_t num_loaded)
+{
+    tx_phases_t phases;
+    if (parseTransactionPhases("assets/profiles/" + fileName, phases)
+            || generator.init(phases, num_pairs, 0, 0, 42, num_loaded)) {
+        std::cout << "error: could not set up generator for " << fileName << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    int err = 0;
+
+    // Zipf keys
+    tx_generator_t zipf;
+    if (initGenerator(zipf, "sap-oltp-zipf.json", 1000000, 0))
+        return 1;
+    err |= testThreadCounts("zipf", zipf, 0, 5000);
+
+    // Inserts and deletes, where each range depends on those before it
+    tx_generator_t churn;
+    if (initGenerator(churn, "sap-oltp-churn.json", 1000000, 500000))
+        return 1;
+    if (churn.checkKeyChanges(churn.countKeyChanges(0, 5000), 1000000))
+        return 1;
+    err |= testThreadCounts("churn", churn, 0, 5000);
+    err |= testThreadCounts("churn-offset", churn, 3000, 5000);
+
+    // Ranges across a phase boundary
+    tx_generator_t shift;
+    if (initGenerator(shift, "sap-oltp-shift.json", 1000000, 0))
+        return 1;
+    err |= testThreadCounts("shift", shift, 49000, 51000);
+
+    // Partitioned pairs
+    tx_generator_t partitioned;
+    if (initGenerator(partitioned, "sap-oltp-churn.json", 1000000, 500000)
+            || partitioned.partition(4, 0.1, 5000))
+        return 1;
+    err |= testThreadCounts("partitioned", partitioned, 0, 5000);
+
+    return err;
+}
@@ -1,14 +1,188 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+#include <fstream>
+#include <random>
 #include <string>
 #include <iostream>
 
 #include "workload.hpp"
+#include "workload-stream.hpp"
 
-int main(int argc, char* argv[])
+using namespace bench::tools;
+
+static bool sameWorkload(const workload_t& a, const workload_t& b)
+{
+    return a.commands().size() == b.commands().size()
+        && std::equal(a.commands().begin(), a.commands().end(), b.commands().begin(),
+                [](const workload_cmd_t& x, const workload_cmd_t& y) {
+                    return x.opcode() == y.opcode() && x.pos() == y.pos();
+                })
+        && a.txOffsets() == b.txOffsets()
+        && a.phaseStarts() == b.phaseStarts();
+}
+
+/**
+ * Writes work in the given format and reads it back.
+ */
+static int roundTrip(const char* name, const workload_t& work, workload_format_t format)
+{
+    const std::string filePath = std::string{"/tmp/workload-test-"} + name;
+    workload_t read;
+    const auto failed = writeWorkload(filePath, work, format)
+        || parseWorkload(filePath, read)
+        || !sameWorkload(work, read);
+    std::remove(filePath.c_str());
+    if (failed) {
+        std::cout << "error: round trip of " << name << " failed\n";
+        return 1;
+    }
+    std::cout << name << " ok\n";
+    return 0;
+}
+
+/**
+ * Writes work as a binary workload and streams the given ranges of it back
+ * in small blocks.
+ */
+static int streamRoundTrip(const char* name, const workload_t& work, workload_format_t format,
+        const std::vector<workload_range_t>& ranges)
+{
+    const std::string filePath = std::string{"/tmp/workload-test-"} + name;
+    bool failed = writeWorkload(filePath, work, format);
+    if (!failed) {
+        workload_stream_t stream;
+        failed = stream.open(filePath, WORKLOAD_POS_MASK + 1, ranges, 64);
+        for (const auto& range : ranges) {
+            for (auto i = range.first_tx; !failed && i < range.last_tx; ++i) {
+                const auto expected = work[i];
+                const auto tx = stream[i];
+                failed = tx.size() != expected.size()
+                    || !std::equal(tx.begin(), tx.end(), expected.begin(),
+                            [](const workload_cmd_t& x, const workload_cmd_t& y) {
+                                return x.opcode() == y.opcode() && x.pos() == y.pos();
+                            });
+            }
+        }
+    }
+    std::remove(filePath.c_str());
+    if (failed) {
+        std::cout << "error: stream round trip of " << name << " failed\n";
+        return 1;
+    }
+    std::cout << name << " ok\n";
+    return 0;
+}
+
+static int testRoundTrips()
+{
+    int err = 0;
+    const workload_format_t formats[] = {workload_format_t::Json, workload_format_t::Bin, workload_format_t::Packed};
+    const char* names[] = {"json", "bin", "packed"};
+
+    // Empty workload
+    workload_t empty;
+    for (std::size_t f = 0; f < 3; ++f)
+        err |= roundTrip((std::string{"empty."} + names[f]).c_str(), empty, formats[f]);
+
+    // Empty transactions at the start, in between and at the end, all
+    // opcodes, and the largest positions
+    workload_t edges;
+    edges.finishTx();
+    edges.appendCmd({tx_opcode_t::Get, 1});
+    edges.appendCmd({tx_opcode_t::Put, WORKLOAD_POS_MASK});
+    edges.appendCmd({tx_opcode_t::Ins, 0});
+    edges.finishTx();
+    edges.finishTx();
+    edges.appendCmd({tx_opcode_t::Del, WORKLOAD_POS_MASK - 1});
+    edges.appendCmd({tx_opcode_t::Rmw, 2});
+    edges.appendCmd({tx_opcode_t::Get, WORKLOAD_POS_MASK});
+    edges.finishTx();
+    edges.finishTx();
+    for (std::size_t f = 0; f < 3; ++f)
+        err |= roundTrip((std::string{"edges."} + names[f]).c_str(), edges, formats[f]);
+
+    // Two packed blocks of WORKLOAD_PACKED_BLOCK_TXS transactions and a
+    // partial one. Close positions are delta coded (first and last block),
+    // random ones bit-packed (second block). Positions of the last
+    // block come close to WORKLOAD_POS_MASK. Phases start at and next to
+    // block boundaries.
+    const std::size_t num_txs = 2 * WORKLOAD_PACKED_BLOCK_TXS + 500;
+    workload_t blocks;
+    std::mt19937_64 rng{42};
+    for (std::size_t i = 0; i < num_txs; ++i) {
+        const auto length = rng() % 8;
+        for (std::size_t j = 0; j < length; ++j) {
+            const auto opcode = static_cast<tx_opcode_t>(rng() % (static_cast<unsigned>(TX_OPCODE_MAX) + 1));
+            const auto block = i / WORKLOAD_PACKED_BLOCK_TXS;
+            const auto pos = block == 0 ? i * 8 + j
+                : block == 1 ? rng() % (1 << 20)
+                : WORKLOAD_POS_MASK - (num_txs - i) * 8 + j + 1;
+            blocks.appendCmd({opcode, pos});
+        }
+        blocks.finishTx();
+    }
+    blocks.setPhases({0, WORKLOAD_PACKED_BLOCK_TXS - 1, 2 * WORKLOAD_PACKED_BLOCK_TXS});
+    for (std::size_t f = 0; f < 3; ++f)
+        err |= roundTrip((std::string{"blocks."} + names[f]).c_str(), blocks, formats[f]);
+
+    // Ranges across block boundaries, streamed in blocks smaller than packed ones
+    const std::vector<workload_range_t> ranges = {
+        {0, 1, {}},
+        {WORKLOAD_PACKED_BLOCK_TXS - 100, WORKLOAD_PACKED_BLOCK_TXS + 100, {}},
+        {2 * WORKLOAD_PACKED_BLOCK_TXS - 1, num_txs, {}},
+    };
+    for (std::size_t f = 1; f < 3; ++f)
+        err |= streamRoundTrip((std::string{"blocks-stream."} + names[f]).c_str(), blocks, formats[f], ranges);
+
+    // Commands which would bit-pack into zero bits
+    workload_t zeros;
+    for (std::size_t i = 0; i < num_txs; ++i) {
+        zeros.appendCmd({tx_opcode_t::Get, 0});
+        zeros.finishTx();
+    }
+    err |= roundTrip("zeros.packed", zeros, workload_format_t::Packed);
+
+    return err;
+}
+
+/**
+ * Checks that a packed workload claiming more commands than its size allows
+ * is rejected before anything is allocated for them.
+ */
+static int testTruncated()
 {
-    using namespace bench::tools;
+    const std::string filePath = "/tmp/workload-test-truncated.packed";
+    workload_t work;
+    work.appendCmd({tx_opcode_t::Put, 7});
+    work.finishTx();
+    workload_t read;
+    bool failed = writeWorkload(filePath, work, workload_format_t::Packed);
+    if (!failed) {
+        std::fstream file(filePath, std::fstream::binary | std::fstream::in | std::fstream::out);
+        const std::uint64_t num_cmds = 1ULL << 40;
+        // The header and the end of the block table agree on the number
+        file.seekp(offsetof(workload_header_t, num_cmds));
+        file.write(reinterpret_cast<const char*>(&num_cmds), sizeof(num_cmds));
+        file.seekp(sizeof(workload_header_t) + sizeof(workload_block_entry_t)
+                + offsetof(workload_block_entry_t, first_cmd));
+        file.write(reinterpret_cast<const char*>(&num_cmds), sizeof(num_cmds));
+        file.close();
+        failed = !parseWorkload(filePath, read);
+    }
+    std::remove(filePath.c_str());
+    if (failed) {
+        std::cout << "error: truncated workload was accepted\n";
+        return 1;
+    }
+    std::cout << "truncated ok\n";
+    return 0;
+}
 
+int main(int argc, char* argv[])
+{
     if (argc < 2)
-        return 0;
+        return testRoundTrips() | testTruncated();
 
     const std::string filePath = argv[1];
     workload_t work;
@@ -17,10 +191,11 @@ int main(int argc, char* argv[])
 
     std::size_t i = 0;
     std::printf("num_txs = %zu\n", work.size());
-    for (const auto& tx : work) {
-        std::printf("tx #%zu [size=%zu]\n", (i++), tx.size());
-        for (const auto& [cmd, pos] : tx) {
-            std::cout << "  " << cmd << " at " << pos << std::endl;
+    for (; i < work.size(); ++i) {
+        const auto tx = work[i];
+        std::printf("tx #%zu [size=%zu]\n", i, tx.size());
+        for (const auto& cmd : tx) {
+            std::cout << "  " << cmd.opcode() << " at " << cmd.pos() << std::endl;
         }
     }
     return 0;
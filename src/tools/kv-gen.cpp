@@ -1,62 +1,599 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
+#include <thread>
 #include <random>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include <getopt.h>   // getopt_long
+#include <fcntl.h>    // open
+#include <unistd.h>   // pwrite, ftruncate, close
+
+#include "dataset.hpp"
+#include "rng.hpp"
 
 namespace app
 {
-    constexpr char alpha[] = "abcdefghijklmnopqrstuvwxyz0123456789";
-    constexpr std::size_t alpha_size = sizeof(alpha) - 1; // do not count terminal byte
+    using bench::tools::CounterRng;
+    using bench::tools::Permutation;
+    using bench::tools::generatePair;
+
     constexpr char delim = ';';
 
+    // Number of bytes each thread generates before writing them out
+    constexpr std::size_t BUFFER_SIZE = 4ULL * 1024 * 1024;
+
+    // First counter of a pair's stream used for drawing sizes. Lower counters
+    // are used for the contents of the pair.
+    constexpr std::uint64_t SIZE_CTR = 1ULL << 62;
+
+    // Upper bound for sizes drawn from unbounded distributions
+    constexpr std::size_t SIZE_MAX_DEFAULT = 1ULL << 20;
+
+    // Counter of the main stream seeding the permutation of key ordinals
+    constexpr std::uint64_t KEY_ORDER_CTR = ~0ULL;
+
+    // Digits of key ordinals, in ascending character order so that ordinals
+    // of equal width compare like the numbers they encode
+    constexpr char ORDINAL_DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    constexpr std::uint64_t ORDINAL_BASE = sizeof(ORDINAL_DIGITS) - 1;
+
+    // Most digits an ordinal below 2^64 can take up
+    constexpr std::size_t ORDINAL_DIGITS_MAX = 12;
+
+    enum class format_t { Csv, Bin };
+
+    enum class key_mode_t { Random, RandomUnique, Sequential, ShuffledSequential };
+
+    inline double to_unit(std::uint64_t x)
+    {
+        return (x >> 11) * 0x1.0p-53;
+    }
+
+    /**
+     * Distribution of key or value sizes.
+     *
+     * Specified as one of
+     *   N                          every size is N
+     *   uniform:MIN:MAX            uniform on [MIN, MAX]
+     *   zipf:THETA:S1,S2,...       bucket k (counting from 1) has probability
+     *                              proportional to 1/k^THETA
+     *   lognormal:MU:SIGMA[:MIN:MAX]
+     *                              exp(N(MU, SIGMA)), rounded and clamped
+     *   hist:FILE                  empirical histogram, one "SIZE WEIGHT"
+     *                              pair per line
+     */
+    class SizeDist
+    {
+    public:
+        bool parse(const std::string& spec)
+        {
+            std::vector<std::string> fields;
+            std::stringstream ss{spec};
+            for (std::string field; std::getline(ss, field, ':'); )
+                fields.push_back(field);
+            if (fields.empty())
+                return false;
+
+            try {
+                const auto& type = fields[0];
+                if (fields.size() == 1) {
+                    kind = kind_t::Fixed;
+                    min = max = std::stoull(type);
+                }
+                else if (type == "uniform" && fields.size() == 3) {
+                    kind = kind_t::Uniform;
+                    min = std::stoull(fields[1]);
+                    max = std::stoull(fields[2]);
+                }
+                else if (type == "zipf" && fields.size() == 3) {
+                    kind = kind_t::Discrete;
+                    const auto theta = std::stod(fields[1]);
+                    std::stringstream buckets{fields[2]};
+                    for (std::string size; std::getline(buckets, size, ','); ) {
+                        sizes.push_back(std::stoull(size));
+                        weights.push_back(1.0 / std::pow(sizes.size(), theta));
+                    }
+                }
+                else if (type == "lognormal" && (fields.size() == 3 || fields.size() == 5)) {
+                    kind = kind_t::Lognormal;
+                    mu = std::stod(fields[1]);
+                    sigma = std::stod(fields[2]);
+                    min = fields.size() == 5 ? std::stoull(fields[3]) : 1;
+                    max = fields.size() == 5 ? std::stoull(fields[4]) : SIZE_MAX_DEFAULT;
+                }
+                else if (type == "hist" && fields.size() == 2) {
+                    kind = kind_t::Discrete;
+                    if (!read_histogram(fields[1]))
+                        return false;
+                }
+                else {
+                    return false;
+                }
+            }
+            catch (const std::logic_error&) {
+                return false;
+            }
+
+            if (kind == kind_t::Discrete) {
+                if (sizes.empty())
+                    return false;
+                std::partial_sum(weights.begin(), weights.end(), weights.begin());
+                if (weights.back() <= 0)
+                    return false;
+                min = *std::min_element(sizes.begin(), sizes.end());
+                max = *std::max_element(sizes.begin(), sizes.end());
+            }
+            return min <= max;
+        }
+
+        bool fixed() const { return kind == kind_t::Fixed; }
+        std::size_t lower() const { return min; }
+        std::size_t upper() const { return max; }
+
+        /**
+         * Draws a size using counters ctr and ctr + 1 of the given stream.
+         */
+        std::size_t sample(const CounterRng& rng, std::uint64_t ctr) const
+        {
+            switch (kind) {
+            case kind_t::Fixed:
+                return min;
+
+            case kind_t::Uniform:
+                return min + static_cast<std::size_t>(to_unit(rng(ctr)) * (max - min + 1));
+
+            case kind_t::Discrete:
+                {
+                    const auto u = to_unit(rng(ctr)) * weights.back();
+                    const auto it = std::upper_bound(weights.begin(), weights.end(), u);
+                    return sizes[std::min<std::size_t>(it - weights.begin(), sizes.size() - 1)];
+                }
+
+            case kind_t::Lognormal:
+                {
+                    // Box-Muller transform
+                    const auto u1 = 1.0 - to_unit(rng(ctr));
+                    const auto u2 = to_unit(rng(ctr + 1));
+                    const auto z = std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+                    const auto size = std::llround(std::exp(mu + sigma * z));
+                    return std::clamp<std::size_t>(std::max(size, 0LL), min, max);
+                }
+            }
+            return min;
+        }
+
+    private:
+        enum class kind_t { Fixed, Uniform, Discrete, Lognormal };
+
+        bool read_histogram(const std::string& path)
+        {
+            std::ifstream ifs{path};
+            if (!ifs.is_open())
+                return false;
+
+            std::string line;
+            while (std::getline(ifs, line)) {
+                if (line.empty() || line[0] == '#')
+                    continue;
+                std::stringstream ss{line};
+                std::size_t size;
+                double weight;
+                if (!(ss >> size >> weight) || weight < 0)
+                    return false;
+                sizes.push_back(size);
+                weights.push_back(weight);
+            }
+            return true;
+        }
+
+        kind_t kind = kind_t::Fixed;
+        std::size_t min = 0;
+        std::size_t max = 0;
+        double mu = 0;
+        double sigma = 0;
+        std::vector<std::size_t> sizes;
+        std::vector<double> weights;
+    };
+
+    /**
+     * Order of the generated keys.
+     *
+     * Except in random mode, each key starts with a fixed-width base-36
+     * ordinal and is filled up with random characters as usual. Ordinals
+     * are distinct, so keys are distinct as well.
+     *   random                 keys are entirely random and may collide
+     *   random-unique          ordinals are a random sample of all ordinals
+     *                          that fit into the shortest key
+     *   sequential             pair i has ordinal i, so keys are ascending
+     *   shuffled-sequential    ordinals are a permutation of [0, NUM_PAIRS)
+     */
+    class KeyOrder
+    {
+    public:
+        bool init(key_mode_t mode, std::size_t num_pairs,
+                std::size_t key_size_min, std::uint64_t seed)
+        {
+            this->mode = mode;
+            if (mode == key_mode_t::Random)
+                return true;
+
+            // Ordered keys have as few digits as possible, unique keys use
+            // as many as possible to look random
+            std::uint64_t domain = 1;
+            digits = 0;
+            if (mode == key_mode_t::RandomUnique) {
+                for (; digits < std::min(key_size_min, ORDINAL_DIGITS_MAX); ++digits)
+                    domain *= ORDINAL_BASE;
+            }
+            else {
+                for (; domain < num_pairs && digits < key_size_min; ++digits)
+                    domain *= ORDINAL_BASE;
+            }
+            if (domain < num_pairs)
+                return false;
+
+            if (mode != key_mode_t::Sequential) {
+                const auto size = mode == key_mode_t::RandomUnique ? domain : num_pairs;
+                permutation = Permutation{size, CounterRng{seed}(KEY_ORDER_CTR)};
+            }
+            return true;
+        }
+
+        /**
+         * Overwrites the first characters of the key of the given pair with
+         * its ordinal.
+         */
+        void apply(std::uint64_t pair, char* key) const
+        {
+            if (mode == key_mode_t::Random)
+                return;
+
+            auto ordinal = mode == key_mode_t::Sequential ? pair : permutation(pair);
+            for (auto i = digits; i--; ) {
+                key[i] = ORDINAL_DIGITS[ordinal % ORDINAL_BASE];
+                ordinal /= ORDINAL_BASE;
+            }
+        }
+
+    private:
+        key_mode_t mode = key_mode_t::Random;
+        std::size_t digits = 0;
+        Permutation permutation{1, 0};
+    };
+
+    struct ProgramArgs
+    {
+        SizeDist key_size;
+        SizeDist val_size;
+        std::size_t num_pairs;
+        key_mode_t key_mode = key_mode_t::Random;
+        KeyOrder key_order;
+        std::string file;
+        format_t format = format_t::Csv;
+        std::uint64_t seed = std::random_device{}();
+        std::size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    };
+
     void usage()
     {
-        std::cout << "usage: gen_data KEY_SIZE VAL_SIZE NUM_PAIRS FILE\n";
+        std::cout << "usage: kv-gen [options] KEY_SIZE VAL_SIZE NUM_PAIRS FILE\n";
+        std::cout << "\nKEY_SIZE and VAL_SIZE are either a number of bytes or a distribution:\n";
+        std::cout << "\tuniform:MIN:MAX\n";
+        std::cout << "\t\tUniformly distributed on [MIN, MAX].\n";
+        std::cout << "\tzipf:THETA:S1,S2,...\n";
+        std::cout << "\t\tOne of the given sizes, the k-th with probability proportional to 1/k^THETA.\n";
+        std::cout << "\tlognormal:MU:SIGMA[:MIN:MAX]\n";
+        std::cout << "\t\texp(N(MU, SIGMA)) rounded and clamped to [MIN, MAX] (default = [1, " << SIZE_MAX_DEFAULT << "]).\n";
+        std::cout << "\thist:FILE\n";
+        std::cout << "\t\tEmpirical histogram with one 'SIZE WEIGHT' pair per line.\n";
+        std::cout << "\noptions:\n";
+        std::cout << "\t-f, --format FORMAT\n";
+        std::cout << "\t\tOutput format, one of {csv | bin} (default = csv).\n";
+        std::cout << "\t\tcsv writes one KEY;VALUE pair per line, bin writes a header\n";
+        std::cout << "\t\tfollowed by densely packed records.\n";
+        std::cout << "\t-k, --key-mode MODE\n";
+        std::cout << "\t\tOrder of the keys, one of {random | random-unique | sequential |\n";
+        std::cout << "\t\tshuffled-sequential} (default = random). Random keys may collide.\n";
+        std::cout << "\t\tIn the other modes, keys start with distinct base-36 numbers:\n";
+        std::cout << "\t\trandom-unique draws them from all numbers fitting into the shortest\n";
+        std::cout << "\t\tkey, sequential counts up from 0 and shuffled-sequential permutes\n";
+        std::cout << "\t\tthe sequential ones.\n";
+        std::cout << "\t-s, --seed INT\n";
+        std::cout << "\t\tSeed of the random number generator (default = random).\n";
+        std::cout << "\t\tThe output only depends on the seed, not on the number of threads.\n";
+        std::cout << "\t-t, --num-threads INT\n";
+        std::cout << "\t\tThe number of threads generating pairs (default = #cpus).\n";
+        std::cout << "\t-h, --help\n";
+        std::cout << "\t\tShow this help text.\n";
     }
 
-    void generate_pairs(const std::size_t key_size, const std::size_t val_size,
-            const std::size_t num_pairs, const std::string& file)
+    bool write_all(int fd, const char* buf, std::size_t size, off_t offset)
     {
-        char* key = new char[key_size + 1];
-        char* val = new char[val_size + 1];
-        key[key_size] = 0;
-        val[val_size] = 0;
+        while (size) {
+            const auto ret = ::pwrite(fd, buf, size, offset);
+            if (ret <= 0)
+                return false;
+            buf += ret;
+            size -= ret;
+            offset += ret;
+        }
+        return true;
+    }
 
-        std::random_device rand_dev;
-        std::mt19937 rng(rand_dev());
-        std::uniform_int_distribution<> dist(0, alpha_size - 1);
+    std::pair<std::size_t, std::size_t> pair_sizes(const ProgramArgs& args,
+            const CounterRng& pair_rng)
+    {
+        return {args.key_size.sample(pair_rng, SIZE_CTR),
+                args.val_size.sample(pair_rng, SIZE_CTR + 2)};
+    }
 
-        std::ofstream ofstream(file);
-        for (std::size_t i=0; i<num_pairs; ++i) {
-            for (std::size_t i=0; i<key_size; ++i) {
-                key[i] = alpha[dist(rng)];
+    /**
+     * Returns the number of bytes pairs [first, last) occupy in the output.
+     */
+    std::size_t measure_range(const ProgramArgs& args, std::size_t first,
+            std::size_t last)
+    {
+        const CounterRng rng{args.seed};
+        const auto overhead = args.format == format_t::Csv ? 2 : 0;
+        std::size_t bytes = 0;
+        for (std::size_t pair = first; pair < last; ++pair) {
+            const auto [key_size, val_size] = pair_sizes(args, CounterRng{rng(pair)});
+            bytes += key_size + val_size + overhead;
+        }
+        return bytes;
+    }
+
+    /**
+     * Generates pairs [first, last) and writes them at the given file offset.
+     *
+     * Every pair is drawn from its own sub-stream of the seeded generator, so
+     * its contents do not depend on which thread produces it. If table_offset
+     * is non-negative, the offsets of the pairs relative to the first record
+     * (starting at record_base) are written there as well.
+     */
+    bool generate_range(const ProgramArgs& args, int fd, std::size_t first,
+            std::size_t last, off_t offset, std::uint64_t record_base,
+            off_t table_offset)
+    {
+        const CounterRng rng{args.seed};
+        const auto csv = args.format == format_t::Csv;
+        const auto record_size_max = args.key_size.upper() + args.val_size.upper() + (csv ? 2 : 0);
+        const auto buffer_size = std::max(BUFFER_SIZE, record_size_max);
+
+        std::vector<char> buffer(buffer_size);
+        std::vector<std::uint64_t> table;
+        std::vector<std::uint64_t> words;
+
+        for (std::size_t pair = first; pair < last; ) {
+            char* p = buffer.data();
+            table.clear();
+            for (; pair < last; ++pair) {
+                const auto [key_size, val_size] = pair_sizes(args, CounterRng{rng(pair)});
+                if (p + key_size + val_size + (csv ? 2 : 0) > buffer.data() + buffer.size())
+                    break;
+
+                const auto key = p;
+                const auto val = p + key_size + (csv ? 1 : 0);
+                generatePair(rng, pair, key, key_size, val, val_size, words);
+                args.key_order.apply(pair, key);
+                table.push_back(record_base + (key - buffer.data()));
+                table.push_back(record_base + (val - buffer.data()));
+                p = val + val_size;
+                if (csv) {
+                    key[key_size] = delim;
+                    *p++ = '\n';
+                }
+            }
+
+            const auto num_bytes = p - buffer.data();
+            if (!write_all(fd, buffer.data(), num_bytes, offset))
+                return false;
+
+            if (table_offset >= 0) {
+                const auto table_bytes = table.size() * sizeof(std::uint64_t);
+                if (!write_all(fd, reinterpret_cast<const char*>(table.data()), table_bytes, table_offset))
+                    return false;
+                table_offset += table_bytes;
+            }
+            offset += num_bytes;
+            record_base += num_bytes;
+        }
+        return true;
+    }
+
+    int generate_pairs(const ProgramArgs& args)
+    {
+        const int fd = ::open(args.file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cout << "error: could not open file " << args.file << "\n";
+            return 1;
+        }
+
+        const auto csv = args.format == format_t::Csv;
+        const auto fixed = args.key_size.fixed() && args.val_size.fixed();
+
+        const auto num_threads = std::max<std::size_t>(1, std::min(args.num_threads, args.num_pairs));
+        const auto num_pairs_each = args.num_pairs / num_threads;
+        auto num_pairs_carry = args.num_pairs % num_threads;
+
+        // Partition pairs into one contiguous range per thread
+        std::vector<std::size_t> bounds{0};
+        for (std::size_t t = 0; t < num_threads; ++t) {
+            std::size_t last = bounds.back() + num_pairs_each;
+            if (num_pairs_carry) {
+                ++last;
+                --num_pairs_carry;
+            }
+            bounds.push_back(last);
+        }
+
+        // Determine where each range starts in the output. Sizes are drawn
+        // from the pairs' own streams, so this pass only has to redraw them.
+        std::vector<std::size_t> range_bytes(num_threads);
+        {
+            std::vector<std::thread> threads;
+            for (std::size_t t = 0; t < num_threads; ++t) {
+                threads.emplace_back([&, t]() {
+                    range_bytes[t] = measure_range(args, bounds[t], bounds[t + 1]);
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+        }
+        std::vector<std::size_t> range_offsets(num_threads + 1, 0);
+        std::partial_sum(range_bytes.begin(), range_bytes.end(), range_offsets.begin() + 1);
+        const auto total_bytes = range_offsets.back();
+
+        off_t data_offset = 0;
+        off_t table_offset = -1;
+        if (!csv) {
+            const auto version = fixed
+                ? bench::tools::DATASET_VERSION_FIXED
+                : bench::tools::DATASET_VERSION_VARIABLE;
+            bench::tools::dataset_header_t header;
+            bench::tools::initDatasetHeader(header, version,
+                    args.key_size.upper(), args.val_size.upper(), args.num_pairs);
+
+            bool ok = write_all(fd, reinterpret_cast<const char*>(&header), sizeof(header), 0);
+            data_offset = sizeof(header);
+            if (!fixed) {
+                // The table is terminated by the end of the last value
+                const std::uint64_t table_end = total_bytes;
+                table_offset = data_offset;
+                data_offset += (2 * args.num_pairs + 1) * sizeof(std::uint64_t);
+                ok = ok && write_all(fd, reinterpret_cast<const char*>(&table_end),
+                        sizeof(table_end), data_offset - sizeof(table_end));
             }
-            for (std::size_t i=0; i<val_size; ++i) {
-                val[i] = alpha[dist(rng)];
+            if (!ok) {
+                std::cout << "error: could not write file " << args.file << "\n";
+                ::close(fd);
+                return 1;
             }
-            ofstream << key << delim;
-            ofstream << val << '\n';
         }
 
-        delete[] key;
-        delete[] val;
+        // Size the file up front so threads can write their ranges in any order
+        if (::ftruncate(fd, data_offset + total_bytes)) {
+            std::cout << "error: could not resize file " << args.file << "\n";
+            ::close(fd);
+            return 1;
+        }
+
+        std::vector<std::thread> threads;
+        std::vector<char> results(num_threads, true);
+        for (std::size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                const off_t range_table_offset = table_offset < 0
+                    ? -1
+                    : table_offset + 2 * bounds[t] * sizeof(std::uint64_t);
+                results[t] = generate_range(args, fd, bounds[t], bounds[t + 1],
+                        data_offset + range_offsets[t], range_offsets[t], range_table_offset);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        ::close(fd);
+        if (std::count(results.begin(), results.end(), false)) {
+            std::cout << "error: could not write file " << args.file << "\n";
+            return 1;
+        }
+        return 0;
     }
 }
 
 int main(int argc, char* argv[])
 {
+    static struct option longopts[] = {
+        { "format"      , required_argument , NULL , 'f' },
+        { "key-mode"    , required_argument , NULL , 'k' },
+        { "seed"        , required_argument , NULL , 's' },
+        { "num-threads" , required_argument , NULL , 't' },
+        { "help"        , no_argument       , NULL , 'h' },
+        { NULL          , 0                 , NULL , 0 }
+    };
+
+    app::ProgramArgs args;
+
+    char ch;
+    while ((ch = getopt_long(argc, argv, "f:k:s:t:h", longopts, NULL)) != -1) {
+        switch (ch) {
+        case 'f':
+            if (std::string{optarg} == "csv") {
+                args.format = app::format_t::Csv;
+            }
+            else if (std::string{optarg} == "bin") {
+                args.format = app::format_t::Bin;
+            }
+            else {
+                app::usage();
+                return 0;
+            }
+            break;
+
+        case 'k':
+            if (std::string{optarg} == "random") {
+                args.key_mode = app::key_mode_t::Random;
+            }
+            else if (std::string{optarg} == "random-unique") {
+                args.key_mode = app::key_mode_t::RandomUnique;
+            }
+            else if (std::string{optarg} == "sequential") {
+                args.key_mode = app::key_mode_t::Sequential;
+            }
+            else if (std::string{optarg} == "shuffled-sequential") {
+                args.key_mode = app::key_mode_t::ShuffledSequential;
+            }
+            else {
+                app::usage();
+                return 0;
+            }
+            break;
+
+        case 's':
+            args.seed = std::stoull(optarg);
+            break;
+
+        case 't':
+            args.num_threads = std::stoull(optarg);
+            break;
+
+        case 'h':
+        default:
+            app::usage();
+            return 0;
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
     if (argc < 4) {
         app::usage();
         return 0;
     }
 
-    const std::size_t key_size = std::stoi(argv[1]);
-    const std::size_t val_size = std::stoi(argv[2]);
-    const std::size_t num_pairs = std::stoi(argv[3]);
-    const std::string file = argv[4];
+    if (!args.key_size.parse(argv[0])) {
+        std::cout << "error: invalid key size " << argv[0] << "\n";
+        return 1;
+    }
+    if (!args.val_size.parse(argv[1])) {
+        std::cout << "error: invalid value size " << argv[1] << "\n";
+        return 1;
+    }
+    args.num_pairs = std::stoull(argv[2]);
+    args.file = argv[3];
 
-    app::generate_pairs(key_size, val_size, num_pairs, file);
+    if (!args.key_order.init(args.key_mode, args.num_pairs, args.key_size.lower(), args.seed)) {
+        std::cout << "error: keys of " << args.key_size.lower() << " bytes cannot hold "
+            << args.num_pairs << " distinct keys\n";
+        return 1;
+    }
 
-    return 0;
+    return app::generate_pairs(args);
 }
@@ -6,14 +6,18 @@
 #include <cmath>    // std::ceil, std::log10
 #include <algorithm>// std::min_element, std::max_element
 #include <stdexcept>// std::min_element, std::max_element
-#include <random>   // std::random_device, std::uniform_int_distribution
+#include <random>   // std::random_device
+#include <thread>   // std::thread
 #include <sstream>
+#include <numeric>  // std::partial_sum
 
 #include <getopt.h> // getopt_long
 
 #include "tx-profile.hpp"
 #include "workload.hpp"
 #include "opcode.hpp"
+#include "dataset.hpp"
+#include "tx-gen.hpp"
 
 namespace bench {
 namespace tools {
@@ -22,16 +26,20 @@ namespace tools {
 // TYPES
 // ############################################################################
 
-using KVPair = std::pair<std::string, std::string>;
-
 struct ProgramArgs
 {
     std::string data_path;
     std::string prof_path;
     std::string output_path;
     std::size_t num_txs = 1;
-    std::size_t tx_len_min = 2;
-    std::size_t tx_len_max = 64;
+    std::size_t tx_len_min = 0; // 0 = length_min of each profile
+    std::size_t tx_len_max = 0; // 0 = length_max of each profile
+    std::size_t num_loaded = 0;
+    std::size_t num_partitions = 0;
+    double cross_prob = 0;
+    std::uint64_t seed = std::random_device{}();
+    std::size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    workload_format_t format = workload_format_t::Packed;
     bool verbose = false;
 };
 
@@ -40,117 +48,74 @@ struct ProgramArgs
 // ############################################################################
 
 void run(ProgramArgs& args);
-std::vector<KVPair> fetch_data(const std::string& path);
 void parse_args(int argc, char* argv[], ProgramArgs& args);
 bool validate_args(ProgramArgs& args);
 void print_args(ProgramArgs& args);
 void usage();
 
-const tx_profile_t& select_profile(const tx_profiles_t& profiles, int rand)
-{
-    for (const auto& prof : profiles) {
-        if (rand <= prof.prob) {
-            return prof;
-        }
-        rand -= prof.prob;
-    }
-    throw std::runtime_error("no tx profile for given range!");
-}
-
-const tx_opcode_t select_operation(const tx_profile_t& prof, int rand)
-{
-    for (auto const& [opcode, prob] : prof.ops) {
-        if (rand <= prob) {
-            return opcode;
-        }
-        rand -= prob;
-    }
-    throw std::runtime_error("no tx opcode for given range!");
-}
-
 void run(ProgramArgs& args)
 {
-    // Get sample data
-    const auto pairs = fetch_data(args.data_path);
-
-    // Get transaction profiles
-    tx_profiles_t profiles;
-    if (parseTransactionProfiles(args.prof_path, profiles))
+    // Only the number of pairs matters, so the data set is not loaded
+    std::size_t num_pairs = 0;
+    if (countPairs(args.data_path, num_pairs))
         return;
 
-    // std::sort(profiles.begin(), profiles.end(),
-    //         [](auto a, auto b){ return a->prob <= b->prob; });
-
-    const auto num_txs = args.num_txs;
-    const auto tx_len_min = args.tx_len_min;
-    const auto tx_len_max = args.tx_len_max;
-    const auto output_path = args.output_path;
-
-    std::random_device device;
-    std::mt19937 rng(device());
-
-    // Distribution for selecting profiles, operations
-    std::uniform_int_distribution<> prob_dist{1, 100};
-
-    // Distribution for selecting pairs
-    std::uniform_int_distribution<> pair_dist{0, static_cast<int>(pairs.size() - 1)};
-
-    // Distribution for selecting #ops in a transaction
-    // double tx_len_mean = (tx_len_max - tx_len_min) / 2.0;
-    // std::normal_distribution<> len_dist{
-    //         tx_len_mean,
-    //         std::sqrt(tx_len_mean - tx_len_min)};
-    std::uniform_int_distribution<unsigned long long> len_dist{tx_len_min, tx_len_max};
-
-    workload_t workload{num_txs};
-    for (std::size_t i=0; i<num_txs; ++i) {
-
-        // select random tx profile
-        const auto& prof = select_profile(profiles, prob_dist(rng));
-
-        // select random tx length
-        const auto tx_length = std::round(len_dist(rng));
+    // Get transaction profiles, possibly in a schedule of phases
+    tx_phases_t phases;
+    if (parseTransactionPhases(args.prof_path, phases))
+        return;
 
-        auto& tx = workload[i];
-        tx.reserve(tx_length);
-        tx.resize(tx_length);
+    tx_generator_t generator;
+    if (generator.init(phases, num_pairs, args.tx_len_min, args.tx_len_max, args.seed, args.num_loaded))
+        return;
+    std::cout << "seed=" << args.seed << std::endl;
 
-        // loop for $tx_length steps
-        for (std::size_t step=0; step<tx_length; ++step) {
+    const auto num_txs = generator.scheduleSize() ? generator.scheduleSize() : args.num_txs;
+    if (args.num_partitions && generator.partition(args.num_partitions, args.cross_prob, num_txs))
+        return;
 
-            // select random operation
-            tx[step].opcode = select_operation(prof, prob_dist(rng));
+    // Transaction i only depends on the seed, i and the number of inserts
+    // before it, so each thread can generate a contiguous range on its own
+    // once the inserts of all ranges are counted, and the output does not
+    // depend on the number of threads
+    const auto num_threads = std::max<std::size_t>(1, std::min(args.num_threads, num_txs));
+    const auto run_threads = [num_threads](auto routine) {
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < num_threads; ++t)
+            threads.emplace_back(routine, t);
+        for (auto& thread : threads)
+            thread.join();
+    };
 
-            // select random pair
-            tx[step].pos = pair_dist(rng);
-        }
-    }
-    writeWorkload(output_path, workload);
-}
+    std::vector<tx_cursor_t> cursors(num_threads + 1);
+    run_threads([&](std::size_t t) {
+        cursors[t + 1] = generator.countKeyChanges(num_txs * t / num_threads, num_txs * (t + 1) / num_threads);
+    });
+    std::partial_sum(cursors.begin(), cursors.end(), cursors.begin());
+    if (generator.checkKeyChanges(cursors.back(), num_pairs))
+        return;
 
-std::vector<KVPair> fetch_data(const std::string& path)
-{
-    std::ifstream ifs{path};
-    if (!ifs.is_open())
-        return {};
-
-    std::string line;
-    std::vector<KVPair> pairs;
-    while (std::getline(ifs, line)) {
-        if (!line.empty()) {
-            auto pos_delim = line.find(';');
-            if (pos_delim != std::string::npos) {
-                pairs.emplace_back(
-                    line.substr(0, pos_delim), // get chars before delimiter
-                    line.substr(pos_delim + 1) // get chars after delimiter
-                );
-            }
-            else {
-                throw std::invalid_argument("error: missing delimiter (;) in line");
-            }
-        }
+    std::vector<workload_t> parts(num_threads);
+    run_threads([&](std::size_t t) {
+        const auto first = num_txs * t / num_threads;
+        const auto last = num_txs * (t + 1) / num_threads;
+        parts[t].reserve(last - first, (last - first) * generator.meanLength());
+        generator.generate(first, last, parts[t], cursors[t]);
+    });
+
+    std::size_t num_cmds = 0;
+    for (const auto& part : parts)
+        num_cmds += part.numCmds();
+
+    workload_t workload;
+    workload.reserve(num_txs, num_cmds);
+    for (auto& part : parts) {
+        workload.append(part);
+        part = workload_t{};
     }
-    return pairs;
+    if (generator.phaseStarts().size() > 1)
+        workload.setPhases(generator.phaseStarts());
+    writeWorkload(args.output_path, workload, args.format);
 }
 
 void parse_args(int argc, char* argv[], ProgramArgs& args)
@@ -161,14 +126,21 @@ void parse_args(int argc, char* argv[], ProgramArgs& args)
         { "tx-profile"    , required_argument , NULL , 'p' },
         { "tx-length-min" , required_argument , NULL , 'i' },
         { "tx-length-max" , required_argument , NULL , 'a' },
+        { "num-loaded"    , required_argument , NULL , 'k' },
+        { "partitions"    , required_argument , NULL , 'P' },
+        { "cross-partition-prob", required_argument , NULL , 'c' },
         { "output"        , required_argument , NULL , 'o' },
+        { "format"        , required_argument , NULL , 'f' },
+        { "seed"          , required_argument , NULL , 's' },
+        { "num-threads"   , required_argument , NULL , 't' },
+        { "threads"       , required_argument , NULL , 't' },
         { "verbose"       , no_argument       , NULL , 'v' },
         { "help"          , no_argument       , NULL , 'h' },
         { NULL            , 0                 , NULL , 0 }
     };
 
     char ch;
-    while ((ch = getopt_long(argc, argv, "d:n:p:i:a:o:hv", longopts, NULL)) != -1) {
+    while ((ch = getopt_long(argc, argv, "d:n:p:i:a:k:P:c:o:f:s:t:hv", longopts, NULL)) != -1) {
         switch (ch) {
         case 'd': // path to data set
             args.data_path = optarg;
@@ -186,6 +158,30 @@ void parse_args(int argc, char* argv[], ProgramArgs& args)
             args.output_path = optarg;
             break;
 
+        case 'f': // output format
+            if (std::string{optarg} == "json") {
+                args.format = workload_format_t::Json;
+            }
+            else if (std::string{optarg} == "bin") {
+                args.format = workload_format_t::Bin;
+            }
+            else if (std::string{optarg} == "packed") {
+                args.format = workload_format_t::Packed;
+            }
+            else {
+                usage();
+                exit(0);
+            }
+            break;
+
+        case 's': // seed
+            args.seed = std::stoull(optarg);
+            break;
+
+        case 't': // number of generating threads
+            args.num_threads = std::stoull(optarg);
+            break;
+
         case 'i': // minimum number of operations in a transaction
             args.tx_len_min = std::stoll(optarg);
             break;
@@ -194,6 +190,18 @@ void parse_args(int argc, char* argv[], ProgramArgs& args)
             args.tx_len_max = std::stoll(optarg);
             break;
 
+        case 'k': // number of pairs in the store before the workload starts
+            args.num_loaded = std::stoull(optarg);
+            break;
+
+        case 'P': // number of key partitions, one per worker
+            args.num_partitions = std::stoull(optarg);
+            break;
+
+        case 'c': // probability of an operation leaving its partition
+            args.cross_prob = std::stod(optarg);
+            break;
+
         case 'v': // verbose mode
             args.verbose = true;
             break;
@@ -222,17 +230,40 @@ void usage()
     std::cout << "\nDESCRIPTION\n";
     std::cout << "\nOPTIONS\n";
     std::cout << "\t-d, --data FILE\n";
-    std::cout << "\t\tPath to a file containing sample data pairs in CSV format. This parameter is required.\n";
+    std::cout << "\t\tPath to a file containing sample data pairs in CSV or binary format. This parameter is required.\n";
+    std::cout << "\t\tAlternatively, proc:NUM_PAIRS:KEY_SIZE:VAL_SIZE[:SEED] derives pairs on the fly without a file.\n";
     std::cout << "\n\t-o, --output FILE\n";
     std::cout << "\t\tPath to file which will contain the generated workload. This parameter is required.\n";
+    std::cout << "\n\t-f, --format FORMAT\n";
+    std::cout << "\t\tFormat of the generated workload, one of {packed | bin | json} (default = packed).\n";
+    std::cout << "\t\tBinary workloads load much faster, JSON is meant for exchanging workloads with other tools.\n";
+    std::cout << "\t\tPacked workloads are compressed binary workloads, typically 2-8 times smaller than bin.\n";
     std::cout << "\n\t-p, --tx-profile FILE\n";
-    std::cout << "\t\tPath to a file containing a transaction profile.\n";
+    std::cout << "\t\tPath to a file containing a transaction profile, or a schedule of phases with profiles of their own.\n";
+    std::cout << "\t\tA schedule sets the number of transactions, so -n is ignored.\n";
     std::cout << "\n\t-n, --num-txs INT\n";
     std::cout << "\t\tThe number of transactions each thread has to perform. (default = " << pargs.num_txs << ")\n";
     std::cout << "\n\t-i, --tx-length-min INT\n";
-    std::cout << "\t\tThe minimum number of operations enclosed in a transaction. (default = " << pargs.tx_len_min << ")\n";
+    std::cout << "\t\tThe minimum number of operations enclosed in a transaction. Overrides length_min of all profiles.\n";
+    std::cout << "\t\t(default = length_min of the profile, or " << TX_LENGTH_MIN_DEFAULT << ")\n";
     std::cout << "\n\t-a, --tx-length-max INT\n";
-    std::cout << "\t\tThe maximum number of operations enclosed in a transaction. (default = " << pargs.tx_len_max << ")\n";
+    std::cout << "\t\tThe maximum number of operations enclosed in a transaction. Overrides length_max of all profiles.\n";
+    std::cout << "\t\t(default = length_max of the profile, or " << TX_LENGTH_MAX_DEFAULT << ")\n";
+    std::cout << "\n\t-k, --num-loaded INT\n";
+    std::cout << "\t\tThe number of pairs in the store when the workload starts, i.e. the first INT pairs of the data set.\n";
+    std::cout << "\t\tInserts write the following pairs, deletes remove the oldest ones. Pass the same number to the\n";
+    std::cout << "\t\tscaling drivers. (default = all)\n";
+    std::cout << "\n\t-P, --partitions INT\n";
+    std::cout << "\t\tSplit the pairs into INT partitions, one per worker of a benchmark run with INT threads. Each\n";
+    std::cout << "\t\ttransaction accesses the partition of the worker running it. (default = off)\n";
+    std::cout << "\n\t-c, --cross-partition-prob FLOAT\n";
+    std::cout << "\t\tThe probability that an operation accesses another partition than its own, from 0 (disjoint\n";
+    std::cout << "\t\tkey sets) to 1. (default = " << pargs.cross_prob << ")\n";
+    std::cout << "\n\t-s, --seed INT\n";
+    std::cout << "\t\tSeed of the random number generator (default = random).\n";
+    std::cout << "\t\tThe output only depends on the seed, not on the number of threads.\n";
+    std::cout << "\n\t-t, --num-threads INT\n";
+    std::cout << "\t\tThe number of threads generating transactions (default = #cpus).\n";
     std::cout << "\n\t-v, --verbose\n";
     std::cout << "\t\tPrint additional info.\n";
     std::cout << "\n\t-h, --help\n";
@@ -257,14 +288,6 @@ bool validate_args(ProgramArgs& args)
         std::cout << "error: spwaning less than 1 transaction is not allowed (see option -n)\n";
         return false;
     }
-    else if (args.tx_len_min < 1) {
-        std::cout << "error: a transaction must perform at least one operation (see option -i)\n";
-        return false;
-    }
-    else if (args.tx_len_max < 1) {
-        std::cout << "error: a transaction must perform at least one operation (see option -a)\n";
-        return false;
-    }
     return true;
 }
 
@@ -276,6 +299,13 @@ void print_args(ProgramArgs& args)
     std::cout << "prof_path: " << args.prof_path << std::endl;
     std::cout << "tx_len_min: " << args.tx_len_min << std::endl;
     std::cout << "tx_len_max: " << args.tx_len_max << std::endl;
+    std::cout << "num_loaded: " << args.num_loaded << std::endl;
+    std::cout << "num_partitions: " << args.num_partitions << std::endl;
+    std::cout << "cross_prob: " << args.cross_prob << std::endl;
+    std::cout << "seed: " << args.seed << std::endl;
+    std::cout << "num_threads: " << args.num_threads << std::endl;
+    std::cout << "format: " << (args.format == workload_format_t::Packed ? "packed"
+            : args.format == workload_format_t::Bin ? "bin" : "json") << std::endl;
 }
 
 } // end namespace tools
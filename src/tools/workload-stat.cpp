@@ -0,0 +1,374 @@
+#include <iostream> // std::cout, std::endl
+#include <vector>   // std::vector
+#include <string>   // std::string
+#include <sstream>  // std::stringstream
+#include <algorithm>// std::sort, std::unique, std::partial_sort, std::upper_bound
+#include <unordered_map>
+#include <limits>   // std::numeric_limits
+
+#include <getopt.h> // getopt_long
+
+#include "workload.hpp"
+#include "opcode.hpp"
+
+namespace bench {
+namespace tools {
+
+// ############################################################################
+// TYPES
+// ############################################################################
+
+struct ProgramArgs
+{
+    std::string workload_path;
+    std::vector<std::size_t> thread_counts{1, 2, 4, 8, 16, 32, 64};
+    std::size_t window = 64;
+    std::size_t num_hot_keys = 10;
+    bool verbose = false;
+};
+
+constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+/**
+ * Accesses to one key of the workload.
+ */
+struct KeyStat
+{
+    std::size_t num_reads = 0;
+    std::size_t num_writes = 0;
+    std::size_t last_reader = NONE;    // latest transaction reading the key
+    std::size_t last_writer = NONE;    // latest transaction writing the key
+    std::vector<std::size_t> writers;  // transactions writing the key within the window
+};
+
+// ############################################################################
+// FUNCTIONS
+// ############################################################################
+
+void run(ProgramArgs& args);
+void parse_args(int argc, char* argv[], ProgramArgs& args);
+bool validate_args(ProgramArgs& args);
+void print_args(ProgramArgs& args);
+void usage();
+
+void print_summary(const std::string& name, std::vector<std::size_t>& values)
+{
+    if (values.empty())
+        return;
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (const auto value : values)
+        sum += value;
+    std::cout << name
+        << " min=" << values.front()
+        << " avg=" << (sum / values.size())
+        << " med=" << values[values.size() / 2]
+        << " p99=" << values[std::min(values.size() - 1, values.size() * 99 / 100)]
+        << " max=" << values.back() << std::endl;
+}
+
+/**
+ * Sorts positions and removes duplicates.
+ */
+void make_set(std::vector<std::uint64_t>& positions)
+{
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+}
+
+/**
+ * Returns the fraction of transactions whose nearest conflicting predecessor
+ * is less than num_threads transactions away.
+ */
+double conflict_probability(const std::vector<std::size_t>& distances, std::size_t num_threads)
+{
+    if (distances.empty() || num_threads < 2)
+        return 0;
+    const auto last = std::upper_bound(distances.begin(), distances.end(), num_threads - 1);
+    return static_cast<double>(last - distances.begin()) / distances.size();
+}
+
+void run(ProgramArgs& args)
+{
+    workload_t workload;
+    if (parseWorkload(args.workload_path, workload))
+        return;
+
+    const auto window = args.window;
+    std::unordered_map<std::uint64_t, KeyStat> keys;
+
+    std::vector<std::size_t> read_set_sizes;
+    std::vector<std::size_t> write_set_sizes;
+    read_set_sizes.reserve(workload.size());
+    write_set_sizes.reserve(workload.size());
+
+    // Distance to the nearest preceding transaction a transaction conflicts
+    // with, NONE if there is none
+    std::vector<std::size_t> ww_distances;
+    std::vector<std::size_t> rw_distances;
+    std::vector<std::size_t> distances;
+    ww_distances.reserve(workload.size());
+    rw_distances.reserve(workload.size());
+    distances.reserve(workload.size());
+
+    // Pairs of transactions at most window transactions apart
+    std::size_t num_window_pairs = 0;
+    std::size_t num_ww_window_pairs = 0;
+    std::vector<std::size_t> counted(window, NONE); // last transaction that counted a predecessor
+
+    std::vector<std::uint64_t> read_set;
+    std::vector<std::uint64_t> write_set;
+
+    for (std::size_t i = 0; i < workload.size(); ++i) {
+        read_set.clear();
+        write_set.clear();
+        for (const auto& cmd : workload[i]) {
+            // A read-modify-write both reads and writes its pair
+            auto& key = keys[cmd.pos()];
+            if (cmd.opcode() == tx_opcode_t::Get || cmd.opcode() == tx_opcode_t::Rmw) {
+                ++key.num_reads;
+                read_set.push_back(cmd.pos());
+            }
+            if (cmd.opcode() != tx_opcode_t::Get) {
+                ++key.num_writes;
+                write_set.push_back(cmd.pos());
+            }
+        }
+        make_set(read_set);
+        make_set(write_set);
+        read_set_sizes.push_back(read_set.size());
+        write_set_sizes.push_back(write_set.size());
+
+        std::size_t ww_distance = NONE;
+        std::size_t rw_distance = NONE;
+        for (const auto pos : read_set) {
+            const auto& key = keys[pos];
+            if (key.last_writer != NONE)
+                rw_distance = std::min(rw_distance, i - key.last_writer);
+        }
+        for (const auto pos : write_set) {
+            const auto& key = keys[pos];
+            if (key.last_writer != NONE)
+                ww_distance = std::min(ww_distance, i - key.last_writer);
+            if (key.last_reader != NONE)
+                rw_distance = std::min(rw_distance, i - key.last_reader);
+
+            // Count each predecessor within the window only once
+            for (auto it = key.writers.rbegin(); it != key.writers.rend() && i - *it <= window; ++it) {
+                auto& last = counted[*it % window];
+                if (last != i) {
+                    last = i;
+                    ++num_ww_window_pairs;
+                }
+            }
+        }
+        ww_distances.push_back(ww_distance);
+        rw_distances.push_back(rw_distance);
+        distances.push_back(std::min(ww_distance, rw_distance));
+        num_window_pairs += std::min(i, window);
+
+        for (const auto pos : read_set)
+            keys[pos].last_reader = i;
+        for (const auto pos : write_set) {
+            auto& key = keys[pos];
+            key.last_writer = i;
+            while (!key.writers.empty() && i + 1 - key.writers.front() > window)
+                key.writers.erase(key.writers.begin());
+            key.writers.push_back(i);
+        }
+    }
+
+    std::cout << "txs=" << workload.size() << std::endl;
+    std::cout << "cmds=" << workload.numCmds() << std::endl;
+    std::cout << "keys=" << keys.size() << std::endl;
+    print_summary("read set", read_set_sizes);
+    print_summary("write set", write_set_sizes);
+
+    // Number of keys and accesses by how often a key is accessed, in
+    // power-of-two buckets
+    std::vector<std::size_t> bucket_keys;
+    std::vector<std::size_t> bucket_accesses;
+    std::vector<std::pair<std::size_t, std::uint64_t>> hot_keys;
+    hot_keys.reserve(keys.size());
+    std::size_t total_accesses = 0; // read-modify-writes count twice
+    for (const auto& [pos, key] : keys) {
+        const auto num_accesses = key.num_reads + key.num_writes;
+        total_accesses += num_accesses;
+        const auto bucket = 63 - __builtin_clzll(num_accesses);
+        if (bucket_keys.size() <= static_cast<std::size_t>(bucket)) {
+            bucket_keys.resize(bucket + 1);
+            bucket_accesses.resize(bucket + 1);
+        }
+        ++bucket_keys[bucket];
+        bucket_accesses[bucket] += num_accesses;
+        hot_keys.emplace_back(num_accesses, pos);
+    }
+    for (std::size_t b = 0; b < bucket_keys.size(); ++b) {
+        if (!bucket_keys[b])
+            continue;
+        std::cout << "key accesses [" << (1ULL << b) << "-" << ((2ULL << b) - 1) << "]"
+            << " keys=" << bucket_keys[b]
+            << " share=" << (100.0 * bucket_accesses[b] / total_accesses) << "%" << std::endl;
+    }
+
+    const auto num_hot_keys = std::min(args.num_hot_keys, hot_keys.size());
+    std::partial_sort(hot_keys.begin(), hot_keys.begin() + num_hot_keys, hot_keys.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+    for (std::size_t k = 0; k < num_hot_keys; ++k) {
+        const auto& key = keys[hot_keys[k].second];
+        std::cout << "hot key pos=" << hot_keys[k].second
+            << " reads=" << key.num_reads
+            << " writes=" << key.num_writes
+            << " share=" << (100.0 * hot_keys[k].first / total_accesses) << "%" << std::endl;
+    }
+
+    std::cout << "window=" << window << std::endl;
+    std::cout << "ww overlapping pairs="
+        << (num_window_pairs ? static_cast<double>(num_ww_window_pairs) / num_window_pairs : 0) << std::endl;
+
+    // With T threads, each transaction runs alongside T - 1 others. Assuming
+    // that transactions do not depend on their position in the workload,
+    // these may as well be its T - 1 predecessors.
+    std::sort(ww_distances.begin(), ww_distances.end());
+    std::sort(rw_distances.begin(), rw_distances.end());
+    std::sort(distances.begin(), distances.end());
+    for (const auto num_threads : args.thread_counts) {
+        std::cout << "threads=" << num_threads
+            << " ww conflict probability=" << conflict_probability(ww_distances, num_threads)
+            << " rw conflict probability=" << conflict_probability(rw_distances, num_threads)
+            << " conflict probability=" << conflict_probability(distances, num_threads) << std::endl;
+    }
+}
+
+void parse_args(int argc, char* argv[], ProgramArgs& args)
+{
+    static struct option longopts[] = {
+        { "workload"    , required_argument , NULL , 'w' },
+        { "num-threads" , required_argument , NULL , 't' },
+        { "window"      , required_argument , NULL , 'W' },
+        { "hot-keys"    , required_argument , NULL , 'k' },
+        { "verbose"     , no_argument       , NULL , 'v' },
+        { "help"        , no_argument       , NULL , 'h' },
+        { NULL          , 0                 , NULL , 0 }
+    };
+
+    char ch;
+    while ((ch = getopt_long(argc, argv, "w:t:W:k:hv", longopts, NULL)) != -1) {
+        switch (ch) {
+        case 'w': // path to workload
+            args.workload_path = optarg;
+            break;
+
+        case 't': // comma-separated thread counts
+            {
+                args.thread_counts.clear();
+                std::stringstream ss{optarg};
+                for (std::string field; std::getline(ss, field, ','); )
+                    args.thread_counts.push_back(std::stoull(field));
+            }
+            break;
+
+        case 'W': // size of the sliding window
+            args.window = std::stoull(optarg);
+            break;
+
+        case 'k': // number of hottest keys to print
+            args.num_hot_keys = std::stoull(optarg);
+            break;
+
+        case 'v': // verbose mode
+            args.verbose = true;
+            break;
+
+        case 'h':
+            usage();
+            exit(0);
+            break;
+
+        default:
+            usage();
+            exit(0);
+        }
+    }
+}
+
+void usage()
+{
+    ProgramArgs pargs;
+    std::cout << "NAME\n";
+    std::cout << "\tworkload-stat - predict contention of a workload\n";
+    std::cout << "\nSYNOPSIS\n";
+    std::cout << "\tworkload-stat options\n";
+    std::cout << "\nDESCRIPTION\n";
+    std::cout << "\tPrints the key access histogram, the hottest keys and the sizes of read and write sets.\n";
+    std::cout << "\tThe conflict probability for T threads is the fraction of transactions sharing a key with one\n";
+    std::cout << "\tof their T - 1 predecessors, which another transaction writes (ww) or reads and writes (rw).\n";
+    std::cout << "\nOPTIONS\n";
+    std::cout << "\t-w, --workload FILE\n";
+    std::cout << "\t\tPath to a workload in any format. This parameter is required.\n";
+    std::cout << "\n\t-t, --num-threads INT[,INT...]\n";
+    std::cout << "\t\tThread counts to estimate the conflict probability for. (default = 1,2,4,8,16,32,64)\n";
+    std::cout << "\n\t-W, --window INT\n";
+    std::cout << "\t\tNumber of preceding transactions checked for overlapping write sets. (default = " << pargs.window << ")\n";
+    std::cout << "\n\t-k, --hot-keys INT\n";
+    std::cout << "\t\tThe number of most frequently accessed keys to print. (default = " << pargs.num_hot_keys << ")\n";
+    std::cout << "\n\t-v, --verbose\n";
+    std::cout << "\t\tPrint additional info.\n";
+    std::cout << "\n\t-h, --help\n";
+    std::cout << "\t\tShow this help text.\n";
+}
+
+bool validate_args(ProgramArgs& args)
+{
+    if (args.workload_path.empty()) {
+        std::cout << "error: no workload provided (see option -w)\n";
+        return false;
+    }
+    else if (args.window < 1) {
+        std::cout << "error: the window must span at least one transaction (see option -W)\n";
+        return false;
+    }
+    for (const auto num_threads : args.thread_counts) {
+        if (num_threads < 1) {
+            std::cout << "error: running less than 1 thread is not possible (see option -t)\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void print_args(ProgramArgs& args)
+{
+    std::cout << "workload_path: " << args.workload_path << std::endl;
+    std::cout << "thread_counts:";
+    for (const auto num_threads : args.thread_counts)
+        std::cout << " " << num_threads;
+    std::cout << std::endl;
+    std::cout << "window: " << args.window << std::endl;
+    std::cout << "num_hot_keys: " << args.num_hot_keys << std::endl;
+}
+
+} // end namespace tools
+} // end namespace bench
+
+int main(int argc, char* argv[])
+{
+    using namespace bench::tools;
+
+    if (argc < 2) {
+        usage();
+        exit(0);
+    }
+
+    ProgramArgs pargs;
+    parse_args(argc, argv, pargs);
+    if (validate_args(pargs)) {
+        if (pargs.verbose)
+            print_args(pargs);
+        run(pargs);
+    }
+    else {
+        usage();
+    }
+    return 0;
+}
@@ -0,0 +1,532 @@
+#include "dataset.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>    // open
+#include <unistd.h>   // close
+#include <sys/mman.h> // mmap, munmap, madvise
+#include <sys/stat.h> // fstat
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace bench {
+namespace tools {
+
+// ############################################################################
+// MappedFile
+// ############################################################################
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : addr{other.addr}
+    , length{other.length}
+{
+    other.addr = nullptr;
+    other.length = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        addr = other.addr;
+        length = other.length;
+        other.addr = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+int MappedFile::open(const std::string& path)
+{
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    struct stat st;
+    if (::fstat(fd, &st)) {
+        ::close(fd);
+        return 1;
+    }
+
+    // An empty file cannot be mapped but is still a valid (empty) file
+    if (st.st_size > 0) {
+        void* mem = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem == MAP_FAILED) {
+            ::close(fd);
+            return 1;
+        }
+        addr = static_cast<const char*>(mem);
+        length = st.st_size;
+    }
+
+    // The mapping stays valid after closing its file descriptor
+    ::close(fd);
+    return 0;
+}
+
+void MappedFile::close()
+{
+    if (addr)
+        ::munmap(const_cast<char*>(addr), length);
+    addr = nullptr;
+    length = 0;
+}
+
+// ############################################################################
+// Arena
+// ############################################################################
+
+constexpr std::size_t HUGE_PAGE_SIZE = 2ULL * 1024 * 1024;
+
+Arena::Arena(Arena&& other) noexcept
+    : addr{other.addr}
+    , length{other.length}
+{
+    other.addr = nullptr;
+    other.length = 0;
+}
+
+Arena& Arena::operator=(Arena&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        addr = other.addr;
+        length = other.length;
+        other.addr = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+Arena::~Arena()
+{
+    release();
+}
+
+int Arena::allocate(std::size_t size, bool huge_pages)
+{
+    release();
+    if (!size)
+        return 0;
+
+    // Huge pages can only back the arena if it is aligned to their size, so
+    // map an extra huge page and trim the unaligned head and tail afterwards
+    if (huge_pages)
+        size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    const auto size_mapped = huge_pages ? size + HUGE_PAGE_SIZE : size;
+    void* mem = ::mmap(nullptr, size_mapped, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        return 1;
+
+    auto begin = static_cast<char*>(mem);
+    if (huge_pages) {
+        const auto misalignment = reinterpret_cast<std::uintptr_t>(begin) % HUGE_PAGE_SIZE;
+        const auto head = misalignment ? HUGE_PAGE_SIZE - misalignment : 0;
+        if (head)
+            ::munmap(begin, head);
+        if (HUGE_PAGE_SIZE - head)
+            ::munmap(begin + head + size, HUGE_PAGE_SIZE - head);
+        begin += head;
+        ::madvise(begin, size, MADV_HUGEPAGE);
+    }
+
+    addr = begin;
+    length = size;
+    return 0;
+}
+
+void Arena::release()
+{
+    if (addr)
+        ::munmap(addr, length);
+    addr = nullptr;
+    length = 0;
+}
+
+// ############################################################################
+// Dataset
+// ############################################################################
+
+void initDatasetHeader(dataset_header_t& header, std::uint32_t version,
+        std::uint64_t key_size, std::uint64_t val_size, std::uint64_t num_pairs)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, DATASET_MAGIC, sizeof(header.magic));
+    header.version = version;
+    header.key_size = key_size;
+    header.val_size = val_size;
+    header.num_pairs = num_pairs;
+}
+
+bool isBinaryDataset(const MappedFile& file)
+{
+    return file.size() >= sizeof(dataset_header_t)
+        && !std::memcmp(file.data(), DATASET_MAGIC, sizeof(DATASET_MAGIC));
+}
+
+int readDatasetHeader(const MappedFile& file, dataset_header_t& header)
+{
+    std::memcpy(&header, file.data(), sizeof(header));
+    const auto payload_size = file.size() - sizeof(header);
+
+    if (header.version == DATASET_VERSION_FIXED) {
+        const auto record_size = header.key_size + header.val_size;
+        if (header.num_pairs
+                && (!record_size || payload_size / record_size < header.num_pairs)) {
+            std::cout << "error: data set is truncated\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (header.version == DATASET_VERSION_VARIABLE) {
+        const auto num_offsets = 2 * header.num_pairs + 1;
+        const auto offsets = reinterpret_cast<const std::uint64_t*>(file.data() + sizeof(header));
+        if (payload_size / sizeof(std::uint64_t) < num_offsets
+                || payload_size - num_offsets * sizeof(std::uint64_t) < offsets[num_offsets - 1]) {
+            std::cout << "error: data set is truncated\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    std::cout << "error: unsupported data set version " << header.version << "\n";
+    return 1;
+}
+
+constexpr char PROCEDURAL_PREFIX[] = "proc:";
+
+/**
+ * Parses NUM_PAIRS:KEY_SIZE:VAL_SIZE[:SEED] of a procedural data set.
+ */
+int parseProcedural(const std::string& spec, std::uint64_t& num_pairs,
+        std::uint64_t& key_size, std::uint64_t& val_size, std::uint64_t& seed)
+{
+    std::vector<std::uint64_t> fields;
+    std::stringstream ss{spec};
+    try {
+        for (std::string field; std::getline(ss, field, ':'); )
+            fields.push_back(std::stoull(field));
+    }
+    catch (const std::logic_error&) {
+        return 1;
+    }
+    if (fields.size() < 3 || fields.size() > 4)
+        return 1;
+
+    num_pairs = fields[0];
+    key_size = fields[1];
+    val_size = fields[2];
+    seed = fields.size() == 4 ? fields[3] : 0;
+    return 0;
+}
+
+kv_pair_t Dataset::generate(std::size_t pos) const
+{
+    thread_local std::string key;
+    thread_local std::string val;
+    thread_local std::vector<std::uint64_t> words;
+
+    key.resize(key_size);
+    val.resize(val_size);
+    generatePair(rng, pos, key.data(), key_size, val.data(), val_size, words);
+    return {key, val};
+}
+
+// Smallest part of a CSV file worth indexing in a thread of its own
+constexpr std::size_t CSV_MIN_CHUNK_SIZE = 4ULL * 1024 * 1024;
+
+/**
+ * Returns the first position in [p, end) holding either a or b, or end if
+ * there is none. Whole vectors of characters are compared at once where the
+ * target supports it.
+ */
+const char* findEither(const char* p, const char* end, char a, char b)
+{
+#if defined(__AVX2__)
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    for (; end - p >= 32; p += 32) {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const unsigned mask = _mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, va), _mm256_cmpeq_epi8(chars, vb)));
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+#elif defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    for (; end - p >= 16; p += 16) {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned mask = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, va), _mm_cmpeq_epi8(chars, vb)));
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == a || *p == b)
+            return p;
+    }
+    return end;
+}
+
+/**
+ * Index of the lines in one chunk of a CSV file.
+ */
+struct CsvChunk
+{
+    std::vector<kv_pair_t> index;
+    std::size_t num_lines = 0;  // lines started in this chunk, empty ones included
+    std::size_t error_line = 0; // line in this chunk lacking a delimiter, 1-based
+};
+
+/**
+ * Indexes the lines in [begin, end), which must start at the beginning of a
+ * line. Indexing stops at the first line without a delimiter.
+ */
+void indexCsvChunk(const char* begin, const char* end, CsvChunk& chunk)
+{
+    for (auto line = begin; line < end; ) {
+        ++chunk.num_lines;
+
+        // The key ends at the first delimiter, the value at the end of line
+        const auto delim = findEither(line, end, ';', '\n');
+        if (delim == end || *delim == '\n') {
+            if (delim != line) {
+                chunk.error_line = chunk.num_lines;
+                return;
+            }
+            line = delim + 1;
+            continue;
+        }
+
+        auto line_end = static_cast<const char*>(std::memchr(delim, '\n', end - delim));
+        if (!line_end)
+            line_end = end;
+        chunk.index.emplace_back(
+            std::string_view(line, delim - line),              // get chars before delimiter
+            std::string_view(delim + 1, line_end - delim - 1)  // get chars after delimiter
+        );
+        line = line_end + 1;
+    }
+}
+
+int loadDataset(const std::string& filePath, dataset_t& data)
+{
+    data.layout = Dataset::layout_t::Csv;
+    data.file.close();
+    data.arena.release();
+    data.index.clear();
+    data.records = nullptr;
+    data.offsets = nullptr;
+    data.key_size = 0;
+    data.val_size = 0;
+    data.num_pairs = 0;
+
+    const auto prefix_size = sizeof(PROCEDURAL_PREFIX) - 1;
+    if (!filePath.compare(0, prefix_size, PROCEDURAL_PREFIX)) {
+        std::uint64_t num_pairs, key_size, val_size, seed;
+        if (parseProcedural(filePath.substr(prefix_size), num_pairs, key_size, val_size, seed)) {
+            std::cout << "error: invalid procedural data set " << filePath << "\n";
+            return 1;
+        }
+        data.layout = Dataset::layout_t::Procedural;
+        data.rng = CounterRng{seed};
+        data.key_size = key_size;
+        data.val_size = val_size;
+        data.num_pairs = num_pairs;
+        return 0;
+    }
+
+    if (data.file.open(filePath)) {
+        std::cout << "error: could not open file\n";
+        return 1;
+    }
+
+    if (isBinaryDataset(data.file)) {
+        dataset_header_t header;
+        if (readDatasetHeader(data.file, header))
+            return 1;
+
+        data.layout = Dataset::layout_t::Fixed;
+        data.records = data.file.data() + sizeof(header);
+        if (header.version == DATASET_VERSION_VARIABLE) {
+            data.layout = Dataset::layout_t::Variable;
+            data.offsets = reinterpret_cast<const std::uint64_t*>(data.records);
+            data.records += (2 * header.num_pairs + 1) * sizeof(std::uint64_t);
+        }
+        data.key_size = header.key_size;
+        data.val_size = header.val_size;
+        data.num_pairs = header.num_pairs;
+
+        // Benchmarks access pairs in no particular order
+        ::madvise(const_cast<char*>(data.file.data()), data.file.size(), MADV_RANDOM);
+        return 0;
+    }
+
+    const char* const begin = data.file.data();
+    const char* const end = begin + data.file.size();
+    if (begin == end)
+        return 0;
+
+    // Each chunk is indexed in a single front-to-back pass
+    ::madvise(const_cast<char*>(begin), data.file.size(), MADV_SEQUENTIAL);
+
+    // Chunks start right after a newline so no line is split between threads
+    const auto num_chunks = std::max<std::size_t>(1, std::min<std::size_t>(
+            std::thread::hardware_concurrency(), data.file.size() / CSV_MIN_CHUNK_SIZE));
+    std::vector<const char*> bounds{begin};
+    for (std::size_t i = 1; i < num_chunks; ++i) {
+        auto bound = std::max(bounds.back(), begin + data.file.size() / num_chunks * i);
+        const auto newline = static_cast<const char*>(std::memchr(bound, '\n', end - bound));
+        bounds.push_back(newline ? newline + 1 : end);
+    }
+    bounds.push_back(end);
+
+    std::vector<CsvChunk> chunks(num_chunks);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < num_chunks; ++i)
+        threads.emplace_back(indexCsvChunk, bounds[i], bounds[i + 1], std::ref(chunks[i]));
+    indexCsvChunk(bounds[0], bounds[1], chunks[0]);
+    for (auto& thread : threads)
+        thread.join();
+
+    // Chunks before the first failing one were indexed completely, so their
+    // line counts yield the global line number
+    std::size_t num_lines = 0;
+    for (const auto& chunk : chunks) {
+        if (chunk.error_line) {
+            throw std::invalid_argument("error: missing delimiter (;) in line "
+                + std::to_string(num_lines + chunk.error_line));
+        }
+        num_lines += chunk.num_lines;
+    }
+
+    // Merge the chunk indexes in file order
+    std::vector<std::size_t> firsts{0};
+    for (const auto& chunk : chunks)
+        firsts.push_back(firsts.back() + chunk.index.size());
+    data.index.resize(firsts.back());
+    threads.clear();
+    for (std::size_t i = 1; i < num_chunks; ++i) {
+        threads.emplace_back([&data, &chunks, &firsts, i] {
+            std::copy(chunks[i].index.begin(), chunks[i].index.end(), data.index.begin() + firsts[i]);
+        });
+    }
+    std::copy(chunks[0].index.begin(), chunks[0].index.end(), data.index.begin());
+    for (auto& thread : threads)
+        thread.join();
+    data.num_pairs = data.index.size();
+
+    // Benchmarks access pairs in no particular order
+    ::madvise(const_cast<char*>(begin), data.file.size(), MADV_RANDOM);
+    return 0;
+}
+
+int countPairs(const std::string& filePath, std::size_t& num_pairs)
+{
+    num_pairs = 0;
+
+    const auto prefix_size = sizeof(PROCEDURAL_PREFIX) - 1;
+    if (!filePath.compare(0, prefix_size, PROCEDURAL_PREFIX)) {
+        std::uint64_t key_size, val_size, seed;
+        if (parseProcedural(filePath.substr(prefix_size), num_pairs, key_size, val_size, seed)) {
+            std::cout << "error: invalid procedural data set " << filePath << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    MappedFile file;
+    if (file.open(filePath)) {
+        std::cout << "error: could not open file\n";
+        return 1;
+    }
+
+    if (isBinaryDataset(file)) {
+        dataset_header_t header;
+        if (readDatasetHeader(file, header))
+            return 1;
+        num_pairs = header.num_pairs;
+        return 0;
+    }
+
+    ::madvise(const_cast<char*>(file.data()), file.size(), MADV_SEQUENTIAL);
+    const char* const end = file.data() + file.size();
+    for (auto line = file.data(); line < end; ) {
+        auto line_end = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!line_end)
+            line_end = end;
+        if (line_end != line)
+            ++num_pairs;
+        line = line_end + 1;
+    }
+    return 0;
+}
+
+int compactDataset(dataset_t& data, bool huge_pages)
+{
+    if (data.layout == Dataset::layout_t::Arena)
+        return 0;
+
+    // Each key and value is followed by a null character
+    const auto num_offsets = 2 * data.num_pairs + 1;
+    const auto table_size = num_offsets * sizeof(std::uint64_t);
+    std::size_t records_size = 0;
+    for (std::size_t i = 0; i < data.num_pairs; ++i) {
+        const auto [key, val] = data[i];
+        records_size += key.size() + val.size() + 2;
+    }
+
+    Arena arena;
+    if (arena.allocate(table_size + records_size, huge_pages)) {
+        std::cout << "error: could not allocate arena\n";
+        return 1;
+    }
+
+    const auto offsets = reinterpret_cast<std::uint64_t*>(arena.data());
+    const auto records = arena.data() + table_size;
+    std::uint64_t offset = 0;
+    for (std::size_t i = 0; i < data.num_pairs; ++i) {
+        const auto [key, val] = data[i];
+        offsets[2 * i] = offset;
+        std::memcpy(records + offset, key.data(), key.size());
+        offset += key.size();
+        records[offset++] = 0;
+        offsets[2 * i + 1] = offset;
+        std::memcpy(records + offset, val.data(), val.size());
+        offset += val.size();
+        records[offset++] = 0;
+    }
+    offsets[num_offsets - 1] = offset;
+
+    // Release the original storage
+    data.file.close();
+    std::vector<kv_pair_t>{}.swap(data.index);
+
+    data.layout = Dataset::layout_t::Arena;
+    data.arena = std::move(arena);
+    data.offsets = offsets;
+    data.records = records;
+    return 0;
+}
+
+} // end namespace tools
+} // end namespace bench
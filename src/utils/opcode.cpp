@@ -16,6 +16,18 @@ std::ostream& operator<<(std::ostream& os, tx_opcode_t op)
         os << "Put";
         break;
 
+    case tx_opcode_t::Ins:
+        os << "Ins";
+        break;
+
+    case tx_opcode_t::Del:
+        os << "Del";
+        break;
+
+    case tx_opcode_t::Rmw:
+        os << "Rmw";
+        break;
+
     default:
         throw std::runtime_error("error: unexpected op code");
     }
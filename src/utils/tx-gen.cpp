@@ -0,0 +1,498 @@
+#include "tx-gen.hpp"
+
+#include <iostream>
+#include <numeric>
+#include <cmath>
+#include <algorithm>
+
+namespace bench {
+namespace tools {
+
+// Profiles and operations are selected by a number drawn from [1, 100]
+constexpr std::uint64_t PROB_RANGE = 100;
+
+// Number of times a step draws a pair before it falls back to a uniformly
+// drawn live pair, see TxGenerator::generate
+constexpr std::uint64_t KEY_DRAWS_MAX = 16;
+
+// Number of times a normal length is drawn before it is clamped to the
+// length range
+constexpr std::uint64_t LENGTH_DRAWS_MAX = 16;
+
+// Counter of the main stream seeding the permutation which scatters Zipf
+// ranks, shared by all profiles so that they agree on the hottest pairs
+constexpr std::uint64_t KEY_SCRAMBLE_CTR = ~0ULL;
+
+/**
+ * Maps a random 64-bit integer onto [0, 1).
+ */
+double toUnit(std::uint64_t x)
+{
+    return (x >> 11) * 0x1.0p-53;
+}
+
+// log1p(x) / x and expm1(x) / x, which stay accurate for x close to 0
+double helper1(double x)
+{
+    return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+}
+
+double helper2(double x)
+{
+    return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+}
+
+void KeySampler::init(const key_distribution_t& dist, std::uint64_t num_pairs, std::uint64_t seed)
+{
+    this->dist = dist;
+    this->num_pairs = num_pairs;
+    num_hot = std::clamp<std::uint64_t>(std::llround(dist.hot_keys * num_pairs), 1, num_pairs);
+    scramble = Permutation{num_pairs, seed};
+
+    h_integral_x1 = hIntegral(1.5) - 1;
+    h_integral_n = hIntegral(num_pairs + 0.5);
+    s = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+}
+
+double KeySampler::h(double x) const
+{
+    return std::exp(-dist.theta * std::log(x));
+}
+
+double KeySampler::hIntegral(double x) const
+{
+    const auto log_x = std::log(x);
+    return helper2((1 - dist.theta) * log_x) * log_x;
+}
+
+double KeySampler::hIntegralInverse(double x) const
+{
+    auto t = x * (1 - dist.theta);
+    if (t < -1)
+        t = -1;
+    return std::exp(helper1(t) * x);
+}
+
+std::uint64_t KeySampler::zipfRank(const CounterRng& rng, std::uint64_t n) const
+{
+    const auto h_integral_n = n == num_pairs ? this->h_integral_n : hIntegral(n + 0.5);
+    for (std::uint64_t attempt = 0; ; ++attempt) {
+        const auto u = h_integral_n + toUnit(rng(attempt)) * (h_integral_x1 - h_integral_n);
+        const auto x = hIntegralInverse(u);
+        auto k = x < 1 ? 1 : static_cast<std::uint64_t>(x + 0.5);
+        if (k > n)
+            k = n;
+        if (k - x <= s || u >= hIntegral(k + 0.5) - h(k))
+            return k;
+    }
+}
+
+std::uint64_t KeySampler::operator()(const CounterRng& rng, std::uint64_t n) const
+{
+    switch (dist.type) {
+    case key_dist_t::Zipf: {
+        const auto rank = zipfRank(rng, n) - 1;
+        return rank < num_pairs ? scramble(rank) : rank;
+    }
+
+    case key_dist_t::Latest:
+        return n - zipfRank(rng, n);
+
+    case key_dist_t::Hotspot: {
+        const auto hot = n == num_pairs ? num_hot
+            : std::clamp<std::uint64_t>(std::llround(dist.hot_keys * n), 1, n);
+        if (hot == n || toUnit(rng(0)) < dist.hot_ops)
+            return uniformBelow(rng(1), hot);
+        return hot + uniformBelow(rng(1), n - hot);
+    }
+
+    default:
+        return uniformBelow(rng(0), n);
+    }
+}
+
+void LengthSampler::init(const length_distribution_t& dist, std::size_t length_min, std::size_t length_max)
+{
+    this->dist = dist;
+    this->length_min = length_min;
+    this->length_max = length_max;
+
+    // Failures before a success of probability p have a mean of (1 - p) / p
+    if (dist.type == length_dist_t::Geometric) {
+        log_q = std::log1p(-1 / (dist.mean - length_min + 1));
+        tail = -std::expm1((length_max - length_min + 1) * log_q);
+    }
+
+    cumulative.clear();
+    double total = 0;
+    for (const auto& bucket : dist.buckets)
+        cumulative.push_back(total += bucket.weight);
+}
+
+std::size_t LengthSampler::operator()(std::uint64_t rand) const
+{
+    switch (dist.type) {
+    case length_dist_t::Normal: {
+        // Box-Muller transform
+        const CounterRng rng{rand};
+        for (std::uint64_t draw = 0; draw < LENGTH_DRAWS_MAX; ++draw) {
+            const auto r = std::sqrt(-2 * std::log1p(-toUnit(rng(2 * draw))));
+            const auto z = r * std::cos(2 * M_PI * toUnit(rng(2 * draw + 1)));
+            const auto length = std::llround(dist.mean + dist.stddev * z);
+            if (length >= static_cast<long long>(length_min) && length <= static_cast<long long>(length_max))
+                return length;
+        }
+        return std::clamp<double>(std::llround(dist.mean), length_min, length_max);
+    }
+
+    case length_dist_t::Geometric: {
+        const auto failures = std::floor(std::log1p(-toUnit(rand) * tail) / log_q);
+        return std::min<double>(length_min + failures, length_max);
+    }
+
+    case length_dist_t::Histogram: {
+        const CounterRng rng{rand};
+        const auto r = toUnit(rng(0)) * cumulative.back();
+        const auto b = std::min<std::size_t>(
+                std::upper_bound(cumulative.begin(), cumulative.end(), r) - cumulative.begin(),
+                cumulative.size() - 1);
+        const auto& bucket = dist.buckets[b];
+        return bucket.min + uniformBelow(rng(1), bucket.max - bucket.min + 1);
+    }
+
+    default:
+        return length_min + uniformBelow(rand, length_max - length_min + 1);
+    }
+}
+
+double LengthSampler::mean() const
+{
+    switch (dist.type) {
+    case length_dist_t::Normal:
+    case length_dist_t::Geometric:
+        return std::clamp<double>(dist.mean, length_min, length_max);
+
+    case length_dist_t::Histogram: {
+        double sum = 0;
+        for (const auto& bucket : dist.buckets)
+            sum += bucket.weight * (bucket.min + bucket.max) / 2;
+        return sum / cumulative.back();
+    }
+
+    default:
+        return (length_min + length_max) / 2.0;
+    }
+}
+
+int validateProfiles(const tx_profiles_t& profiles)
+{
+    const auto sum_probs = [](double sum, const auto& item) { return sum + item.prob; };
+    if (std::accumulate(profiles.begin(), profiles.end(), 0.0, sum_probs) < PROB_RANGE) {
+        std::cout << "error: probabilities of transaction profiles add up to less than " << PROB_RANGE << "\n";
+        return 1;
+    }
+    for (const auto& prof : profiles) {
+        double sum = 0;
+        for (const auto& [opcode, prob] : prof.ops)
+            sum += prob;
+        if (sum < PROB_RANGE) {
+            std::cout << "error: probabilities of operations in profile " << prof.name
+                << " add up to less than " << PROB_RANGE << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int TxGenerator::init(const tx_phases_t& phases, std::size_t num_pairs,
+        std::size_t length_min, std::size_t length_max, std::uint64_t seed,
+        std::size_t num_loaded)
+{
+    if (phases.empty()) {
+        std::cout << "error: no phases to generate transactions for\n";
+        return 1;
+    }
+    for (std::size_t p = 0; p < phases.size(); ++p) {
+        if (validateProfiles(phases[p].profiles))
+            return 1;
+        if (!phases[p].num_txs && p + 1 < phases.size()) {
+            std::cout << "error: phase " << p << " has no transactions\n";
+            return 1;
+        }
+    }
+    if (!num_pairs) {
+        std::cout << "error: no pairs to generate transactions for\n";
+        return 1;
+    }
+    if (!num_loaded)
+        num_loaded = num_pairs;
+    if (num_loaded > num_pairs) {
+        std::cout << "error: cannot load " << num_loaded << " of " << num_pairs << " pairs\n";
+        return 1;
+    }
+    if (length_min && length_max && length_min > length_max) {
+        std::cout << "error: invalid transaction length range [" << length_min << ", " << length_max << "]\n";
+        return 1;
+    }
+
+    this->phases.assign(phases.size(), {});
+    phase_starts.clear();
+    schedule_size = 0;
+    key_changes = false;
+    for (std::size_t p = 0; p < phases.size(); ++p) {
+        auto& phase = this->phases[p];
+        phase.profiles = phases[p].profiles;
+        for (const auto& prof : phase.profiles) {
+            for (const auto& [op, prob] : prof.ops)
+                key_changes |= (op == profile_op_t::Insert || op == profile_op_t::Delete) && prob > 0;
+
+            // An explicit bound wins over the profile's, which wins over the
+            // default one
+            const auto prof_min = length_min ? length_min
+                : prof.length_min ? prof.length_min : TX_LENGTH_MIN_DEFAULT;
+            const auto prof_max = length_max ? length_max
+                : prof.length_max ? prof.length_max : TX_LENGTH_MAX_DEFAULT;
+            if (prof.lengths.type != length_dist_t::Histogram && prof_min > prof_max) {
+                std::cout << "error: invalid transaction length range [" << prof_min << ", " << prof_max
+                    << "] in profile " << prof.name << "\n";
+                return 1;
+            }
+            if (prof.lengths.type == length_dist_t::Geometric && prof.lengths.mean < prof_min) {
+                std::cout << "error: mean transaction length of profile " << prof.name
+                    << " is less than " << prof_min << "\n";
+                return 1;
+            }
+            phase.lengths.emplace_back().init(prof.lengths, prof_min, prof_max);
+        }
+        phase_starts.push_back(schedule_size);
+        schedule_size += phases[p].num_txs;
+    }
+    if (!phases.back().num_txs)
+        schedule_size = 0;
+    this->num_pairs = num_pairs;
+    this->num_loaded = num_loaded;
+    rng = CounterRng{seed};
+    scramble_seed = rng(KEY_SCRAMBLE_CTR);
+    num_partitions = 1;
+    cross_prob = 0;
+    initSamplers();
+    return 0;
+}
+
+double TxGenerator::meanLength() const
+{
+    const auto& phase = phases.front();
+    double sum = 0;
+    double sum_probs = 0;
+    for (std::size_t p = 0; p < phase.profiles.size(); ++p) {
+        sum += phase.profiles[p].prob * phase.lengths[p].mean();
+        sum_probs += phase.profiles[p].prob;
+    }
+    return sum / sum_probs;
+}
+
+int TxGenerator::partition(std::size_t num_partitions, double cross_prob, std::uint64_t num_txs)
+{
+    if (!num_partitions || num_partitions > num_loaded) {
+        std::cout << "error: cannot split " << num_loaded << " pairs into " << num_partitions << " partitions\n";
+        return 1;
+    }
+    if (cross_prob < 0 || cross_prob > 1) {
+        std::cout << "error: probability of cross-partition operations must be in [0, 1]\n";
+        return 1;
+    }
+
+    this->num_partitions = num_partitions;
+    this->cross_prob = cross_prob;
+    partition_txs = schedule_size ? schedule_size : num_txs;
+    initSamplers();
+    return 0;
+}
+
+void TxGenerator::initSamplers()
+{
+    // All profiles share the scramble seed, so that they agree on the
+    // hottest pairs of each partition
+    for (auto& phase : phases) {
+        phase.samplers.resize(phase.profiles.size() * num_partitions);
+        for (std::size_t q = 0; q < phase.profiles.size(); ++q) {
+            for (std::size_t k = 0; k < num_partitions; ++k) {
+                phase.samplers[q * num_partitions + k].init(phase.profiles[q].keys,
+                        partitionSize(num_loaded, k), scramble_seed);
+            }
+        }
+    }
+}
+
+std::size_t TxGenerator::phaseIndex(std::uint64_t i) const
+{
+    return std::upper_bound(phase_starts.begin(), phase_starts.end(), i) - phase_starts.begin() - 1;
+}
+
+std::size_t TxGenerator::homePartition(std::uint64_t i) const
+{
+    const auto p = phaseIndex(i);
+    const auto phase_end = p + 1 < phase_starts.size() ? phase_starts[p + 1] : partition_txs;
+    if (i >= phase_end)
+        return 0;
+    return partOf(phase_end - phase_starts[p], num_partitions, i - phase_starts[p]);
+}
+
+std::uint64_t TxGenerator::partitionSize(std::uint64_t end, std::size_t partition) const
+{
+    return end > partition ? (end - partition - 1) / num_partitions + 1 : 0;
+}
+
+std::size_t TxGenerator::selectProfile(const tx_profiles_t& profiles, std::uint64_t rand) const
+{
+    double r = rand;
+    for (std::size_t p = 0; p < profiles.size(); ++p) {
+        if (r <= profiles[p].prob)
+            return p;
+        r -= profiles[p].prob;
+    }
+    return profiles.size() - 1;
+}
+
+profile_op_t TxGenerator::selectOperation(const tx_profile_t& prof, std::uint64_t rand) const
+{
+    double r = rand;
+    for (const auto& [opcode, prob] : prof.ops) {
+        if (r <= prob)
+            return opcode;
+        r -= prob;
+    }
+    return prof.ops.back().first;
+}
+
+void TxGenerator::generate(std::uint64_t i, std::vector<workload_cmd_t>& cmds, tx_cursor_t& cursor) const
+{
+    // Counters 0 and 1 select profile and length, each step seeds a stream
+    // of its own
+    const CounterRng tx_rng{rng(i)};
+    const auto& phase = phaseOf(i);
+    const auto p = selectProfile(phase.profiles, 1 + uniformBelow(tx_rng(0), PROB_RANGE));
+    const auto& prof = phase.profiles[p];
+    const auto length = phase.lengths[p](tx_rng(1));
+    const auto home = num_partitions > 1 ? homePartition(i) : 0;
+
+    for (std::uint64_t step = 0; step < length; ++step) {
+        const CounterRng step_rng{tx_rng(2 + step)};
+        const auto op = selectOperation(prof, 1 + uniformBelow(step_rng(0), PROB_RANGE));
+        const auto live_begin = cursor.num_deletes;
+        const auto live_end = num_loaded + cursor.num_inserts;
+
+        // Inserts and deletes do not draw a pair, all others draw one from
+        // the live ones
+        if (op == profile_op_t::Insert) {
+            cmds.emplace_back(tx_opcode_t::Ins, live_end);
+            ++cursor.num_inserts;
+            continue;
+        }
+        if (op == profile_op_t::Delete) {
+            cmds.emplace_back(tx_opcode_t::Del, live_begin);
+            ++cursor.num_deletes;
+            continue;
+        }
+
+        // Pairs of a partition are num_partitions positions apart
+        auto partition = home;
+        if (num_partitions > 1 && cross_prob > 0 && toUnit(step_rng(3)) < cross_prob)
+            partition = (home + 1 + uniformBelow(step_rng(4), num_partitions - 1)) % num_partitions;
+        const auto first = partitionSize(live_begin, partition);
+        const auto end = partitionSize(live_end, partition);
+        if (first == end)
+            continue;
+
+        // Pairs are drawn up to the last live one, so that deletes do not
+        // move the popular ones, and drawn again if deleted
+        const auto& sampler = phase.samplers[p * num_partitions + partition];
+        auto index = sampler(CounterRng{step_rng(1)}, end);
+        for (std::uint64_t draw = 1; index < first; ++draw) {
+            const CounterRng draw_rng{step_rng(4 + draw)};
+            index = draw < KEY_DRAWS_MAX ? sampler(draw_rng, end) : first + uniformBelow(draw_rng(0), end - first);
+        }
+        const auto pos = partition + index * num_partitions;
+        switch (op) {
+        case profile_op_t::Get:
+            cmds.emplace_back(tx_opcode_t::Get, pos);
+            break;
+
+        case profile_op_t::Put:
+            cmds.emplace_back(tx_opcode_t::Put, pos);
+            break;
+
+        case profile_op_t::ReadModifyWrite:
+            cmds.emplace_back(tx_opcode_t::Rmw, pos);
+            break;
+
+        case profile_op_t::Scan: {
+            // Scans stay in their partition and stop at the last live pair
+            const auto scan_length = 1 + uniformBelow(step_rng(2), prof.scan_length_max);
+            auto scan_pos = pos;
+            for (std::uint64_t n = 0; n < scan_length && scan_pos < live_end; ++n, scan_pos += num_partitions)
+                cmds.emplace_back(tx_opcode_t::Get, scan_pos);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+}
+
+void TxGenerator::generate(std::uint64_t first, std::uint64_t last, workload_t& workload,
+        tx_cursor_t cursor) const
+{
+    std::vector<workload_cmd_t> cmds;
+    for (auto i = first; i < last; ++i) {
+        cmds.clear();
+        generate(i, cmds, cursor);
+        for (const auto& cmd : cmds)
+            workload.appendCmd(cmd);
+        workload.finishTx();
+    }
+}
+
+tx_cursor_t TxGenerator::countKeyChanges(std::uint64_t first, std::uint64_t last) const
+{
+    tx_cursor_t cursor;
+    if (!key_changes)
+        return cursor;
+
+    // Draws the same numbers as generate() up to the operations
+    for (auto i = first; i < last; ++i) {
+        const CounterRng tx_rng{rng(i)};
+        const auto& phase = phaseOf(i);
+        const auto p = selectProfile(phase.profiles, 1 + uniformBelow(tx_rng(0), PROB_RANGE));
+        const auto& prof = phase.profiles[p];
+        const auto length = phase.lengths[p](tx_rng(1));
+        for (std::uint64_t step = 0; step < length; ++step) {
+            const CounterRng step_rng{tx_rng(2 + step)};
+            const auto op = selectOperation(prof, 1 + uniformBelow(step_rng(0), PROB_RANGE));
+            if (op == profile_op_t::Insert)
+                ++cursor.num_inserts;
+            else if (op == profile_op_t::Delete)
+                ++cursor.num_deletes;
+        }
+    }
+    return cursor;
+}
+
+int TxGenerator::checkKeyChanges(const tx_cursor_t& total, std::size_t num_pairs) const
+{
+    if (num_loaded + total.num_inserts > num_pairs) {
+        std::cout << "error: " << total.num_inserts << " inserts do not fit into " << num_pairs
+            << " pairs with " << num_loaded << " loaded (see option -k)\n";
+        return 1;
+    }
+    if (total.num_deletes >= num_loaded) {
+        std::cout << "error: " << total.num_deletes << " deletes do not leave any of the "
+            << num_loaded << " loaded pairs (see option -k)\n";
+        return 1;
+    }
+    return 0;
+}
+
+} // end namespace tools
+} // end namespace bench
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <stdexcept>
 
 #include "json/json.h"
 
@@ -10,18 +11,109 @@ namespace tools {
 
 int parseProfile(const std::string& profile_key, const Json::Value& node,
         tx_profiles_t& profiles);
+int parseKeyDistribution(const Json::Value& node, key_distribution_t& keys);
+int parseLengthDistribution(const Json::Value& node, length_distribution_t& lengths);
 
-int parseTransactionProfiles(const std::string& filePath,
-        tx_profiles_t& profiles)
+int parseProfiles(const Json::Value& root, tx_profiles_t& profiles);
+
+std::ostream& operator<<(std::ostream& os, profile_op_t op)
+{
+    switch (op) {
+    case profile_op_t::Get:
+        os << "Get";
+        break;
+
+    case profile_op_t::Put:
+        os << "Put";
+        break;
+
+    case profile_op_t::ReadModifyWrite:
+        os << "ReadModifyWrite";
+        break;
+
+    case profile_op_t::Scan:
+        os << "Scan";
+        break;
+
+    case profile_op_t::Insert:
+        os << "Insert";
+        break;
+
+    case profile_op_t::Delete:
+        os << "Delete";
+        break;
+
+    default:
+        throw std::runtime_error("error: unexpected profile operation");
+    }
+    return os;
+}
+
+int readJSONFile(const std::string& filePath, Json::Value& root)
 {
     std::ifstream file(filePath, std::ifstream::binary);
     if (!file.is_open()) {
         std::cout << "error: could not open file\n";
         return 1;
     }
+    file >> root;
+    return 0;
+}
 
+int parseTransactionProfiles(const std::string& filePath,
+        tx_profiles_t& profiles)
+{
     Json::Value root;
-    file >> root;
+    if (readJSONFile(filePath, root))
+        return 1;
+    return parseProfiles(root, profiles);
+}
+
+int parseTransactionPhases(const std::string& filePath,
+        tx_phases_t& phases)
+{
+    Json::Value root;
+    if (readJSONFile(filePath, root))
+        return 1;
+
+    const Json::Value phases_node = root.get("phases", Json::nullValue);
+    if (!phases_node.isArray()) {
+        auto& phase = phases.emplace_back();
+        return parseProfiles(root, phase.profiles);
+    }
+
+    for (const auto& node : phases_node) {
+        auto& phase = phases.emplace_back();
+        const Json::Value& txs = node["txs"];
+        if (!txs.isUInt64() || !txs.asUInt64()) {
+            std::cout << "error: phase " << phases.size() - 1 << " needs a positive number of transactions\n";
+            return 2;
+        }
+        phase.num_txs = txs.asUInt64();
+
+        const Json::Value& profiles = node["profiles"];
+        if (profiles.isString()) {
+            const auto dir_end = filePath.find_last_of('/');
+            const auto dir = dir_end == std::string::npos ? std::string{} : filePath.substr(0, dir_end + 1);
+            const auto path = profiles.asString();
+            if (parseTransactionProfiles(!path.empty() && path.front() == '/' ? path : dir + path, phase.profiles))
+                return 2;
+        }
+        else if (!profiles.isObject() || parseProfiles(profiles, phase.profiles)) {
+            std::cout << "error: could not parse profiles of phase " << phases.size() - 1 << "\n";
+            return 2;
+        }
+    }
+
+    if (phases.empty()) {
+        std::cout << "error: schedule has no phases\n";
+        return 2;
+    }
+    return 0;
+}
+
+int parseProfiles(const Json::Value& root, tx_profiles_t& profiles)
+{
     for (auto key : root.getMemberNames()) {
         if (parseProfile(key, root[key], profiles)) {
             std::cout << "error: could not parse item\n";
@@ -54,10 +146,22 @@ int parseProfile(const std::string& profile_key, const Json::Value& node,
     for (auto key : ops.getMemberNames()) {
         auto value = ops[key].asDouble();
         if (key == "get") {
-            profile.ops.emplace_back(tx_opcode_t::Get, value);
+            profile.ops.emplace_back(profile_op_t::Get, value);
         }
         else if (key == "put") {
-            profile.ops.emplace_back(tx_opcode_t::Put, value);
+            profile.ops.emplace_back(profile_op_t::Put, value);
+        }
+        else if (key == "rmw") {
+            profile.ops.emplace_back(profile_op_t::ReadModifyWrite, value);
+        }
+        else if (key == "scan") {
+            profile.ops.emplace_back(profile_op_t::Scan, value);
+        }
+        else if (key == "ins") {
+            profile.ops.emplace_back(profile_op_t::Insert, value);
+        }
+        else if (key == "del") {
+            profile.ops.emplace_back(profile_op_t::Delete, value);
         }
     }
 
@@ -73,6 +177,138 @@ int parseProfile(const std::string& profile_key, const Json::Value& node,
     if (!length_max.isNull())
         profile.length_max = length_max.asDouble();
 
+    const Json::Value& lengths = node["lengths"];
+    if (!lengths.isNull() && parseLengthDistribution(lengths, profile.lengths))
+        return 1;
+
+    const Json::Value& scan_length_max = node["scan_length_max"];
+    if (!scan_length_max.isNull()) {
+        profile.scan_length_max = scan_length_max.asDouble();
+        if (!profile.scan_length_max)
+            return 1;
+    }
+
+    const Json::Value& keys = node["keys"];
+    if (!keys.isNull() && parseKeyDistribution(keys, profile.keys))
+        return 1;
+
+    return 0;
+}
+
+/**
+ * Parses either the name of a distribution or an object with the name in
+ * "dist" and its parameters, e.g. { "dist": "zipf", "theta": 0.99 }.
+ */
+int parseKeyDistribution(const Json::Value& node, key_distribution_t& keys)
+{
+    const auto& dist = node.isObject() ? node["dist"] : node;
+    if (!dist.isString())
+        return 1;
+
+    const auto name = dist.asString();
+    if (name == "uniform") {
+        keys.type = key_dist_t::Uniform;
+    }
+    else if (name == "zipf") {
+        keys.type = key_dist_t::Zipf;
+    }
+    else if (name == "hotspot") {
+        keys.type = key_dist_t::Hotspot;
+    }
+    else if (name == "latest") {
+        keys.type = key_dist_t::Latest;
+    }
+    else {
+        std::cout << "error: unknown key distribution " << name << "\n";
+        return 1;
+    }
+
+    if (node.isObject()) {
+        if (node.isMember("theta"))
+            keys.theta = node["theta"].asDouble();
+        if (node.isMember("hot_keys"))
+            keys.hot_keys = node["hot_keys"].asDouble();
+        if (node.isMember("hot_ops"))
+            keys.hot_ops = node["hot_ops"].asDouble();
+    }
+
+    if (keys.theta <= 0) {
+        std::cout << "error: theta of key distribution must be positive\n";
+        return 1;
+    }
+    if (keys.hot_keys <= 0 || keys.hot_keys > 1 || keys.hot_ops < 0 || keys.hot_ops > 1) {
+        std::cout << "error: hot_keys must be in (0, 1] and hot_ops in [0, 1]\n";
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Parses either the name of a distribution or an object with the name in
+ * "dist" and its parameters, e.g. { "dist": "normal", "mean": 32, "stddev":
+ * 8 } or { "dist": "histogram", "buckets": [[1, 60], [2, 16, 30], [64, 10]]
+ * }, where each bucket holds a length or a range of lengths and its weight.
+ */
+int parseLengthDistribution(const Json::Value& node, length_distribution_t& lengths)
+{
+    const auto& dist = node.isObject() ? node["dist"] : node;
+    if (!dist.isString())
+        return 1;
+
+    const auto name = dist.asString();
+    if (name == "uniform") {
+        lengths.type = length_dist_t::Uniform;
+    }
+    else if (name == "normal") {
+        lengths.type = length_dist_t::Normal;
+    }
+    else if (name == "geometric") {
+        lengths.type = length_dist_t::Geometric;
+    }
+    else if (name == "histogram") {
+        lengths.type = length_dist_t::Histogram;
+    }
+    else {
+        std::cout << "error: unknown length distribution " << name << "\n";
+        return 1;
+    }
+
+    if (node.isObject()) {
+        if (node.isMember("mean"))
+            lengths.mean = node["mean"].asDouble();
+        if (node.isMember("stddev"))
+            lengths.stddev = node["stddev"].asDouble();
+        for (const auto& bucket : node["buckets"]) {
+            if (!bucket.isArray() || bucket.size() < 2 || bucket.size() > 3) {
+                std::cout << "error: a length bucket holds a length or a range and a weight\n";
+                return 1;
+            }
+            auto& item = lengths.buckets.emplace_back();
+            item.min = bucket[0].asUInt64();
+            item.max = bucket[bucket.size() - 2].asUInt64();
+            item.weight = bucket[bucket.size() - 1].asDouble();
+            if (!item.min || item.min > item.max || item.weight < 0) {
+                std::cout << "error: invalid length bucket [" << item.min << ", " << item.max << "]\n";
+                return 1;
+            }
+        }
+    }
+
+    if ((lengths.type == length_dist_t::Normal || lengths.type == length_dist_t::Geometric) && lengths.mean <= 0) {
+        std::cout << "error: " << name << " length distribution needs a positive mean\n";
+        return 1;
+    }
+    if (lengths.type == length_dist_t::Normal && lengths.stddev <= 0) {
+        std::cout << "error: normal length distribution needs a positive stddev\n";
+        return 1;
+    }
+    double total_weight = 0;
+    for (const auto& bucket : lengths.buckets)
+        total_weight += bucket.weight;
+    if (lengths.type == length_dist_t::Histogram && total_weight <= 0) {
+        std::cout << "error: length histogram needs buckets of positive weight\n";
+        return 1;
+    }
     return 0;
 }
 
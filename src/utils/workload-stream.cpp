@@ -0,0 +1,308 @@
+#include "workload-stream.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+
+#include <fcntl.h>  // open
+#include <unistd.h> // pread, close
+
+namespace bench {
+namespace tools {
+
+bool readAll(int fd, void* buf, std::size_t size, off_t offset)
+{
+    auto dst = static_cast<char*>(buf);
+    while (size) {
+        const auto ret = ::pread(fd, dst, size, offset);
+        if (ret <= 0)
+            return false;
+        dst += ret;
+        size -= ret;
+        offset += ret;
+    }
+    return true;
+}
+
+WorkloadStream::~WorkloadStream()
+{
+    close();
+}
+
+int WorkloadStream::open(const std::string& filePath, std::uint64_t num_pairs,
+        const std::vector<workload_range_t>& ranges, std::size_t block_size)
+{
+    close();
+    this->num_pairs = num_pairs;
+
+    if (readWorkloadHeader(filePath, header))
+        return 1;
+    for (const auto& range : ranges) {
+        if (range.last_tx > header.num_txs) {
+            std::cout << "error: transactions [" << range.first_tx << "-" << range.last_tx
+                << ") are not part of the workload\n";
+            return 1;
+        }
+    }
+
+    fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cout << "error: could not open file\n";
+        return 1;
+    }
+
+    // Packed workloads are located through their block table
+    table.clear();
+    if (header.version == WORKLOAD_VERSION_PACKED) {
+        table.resize(numWorkloadBlocks(header) + 1);
+        if (!readAll(fd, table.data(), table.size() * sizeof(workload_block_entry_t), sizeof(header))) {
+            std::cout << "error: could not read block table\n";
+            close();
+            return 1;
+        }
+    }
+
+    if (start(ranges, header.num_txs, block_size)) {
+        close();
+        return 1;
+    }
+    return 0;
+}
+
+int WorkloadStream::open(const tx_generator_t& generator, const std::vector<workload_range_t>& ranges,
+        std::size_t block_size)
+{
+    close();
+
+    this->generator = &generator;
+    if (start(ranges, SIZE_MAX, block_size)) {
+        close();
+        return 1;
+    }
+    return 0;
+}
+
+int WorkloadStream::start(const std::vector<workload_range_t>& ranges, std::size_t num_txs,
+        std::size_t block_size)
+{
+    for (std::size_t r = 0; r < ranges.size(); ++r) {
+        const auto& range = ranges[r];
+        if (range.first_tx > range.last_tx || range.last_tx > num_txs
+                || (r && range.first_tx < ranges[r - 1].last_tx)) {
+            std::cout << "error: transactions [" << range.first_tx << "-" << range.last_tx
+                << ") are not a valid range\n";
+            return 1;
+        }
+    }
+
+    this->ranges = ranges;
+    this->block_size = std::max<std::size_t>(1, block_size);
+    for (auto& block : blocks) {
+        block.ready = false;
+        block.failed = false;
+    }
+    current = 0;
+    current_first = 0;
+    current_size = 0;
+    stopped = false;
+    prefetcher = std::thread{[this]() { prefetch(); }};
+    return 0;
+}
+
+void WorkloadStream::close()
+{
+    if (prefetcher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopped = true;
+        }
+        cond.notify_all();
+        prefetcher.join();
+    }
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+    generator = nullptr;
+}
+
+workload_tx_t WorkloadStream::advance(std::size_t i)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    for (;;) {
+        // Hand the exhausted block back to the prefetcher
+        if (current_size) {
+            blocks[current].ready = false;
+            current ^= 1;
+            current_size = 0;
+            cond.notify_all();
+        }
+
+        cond.wait(lock, [this]() { return blocks[current].ready; });
+        const auto& block = blocks[current];
+        if (block.failed)
+            throw std::runtime_error("error: could not read workload");
+        if (block.offsets.size() < 2)
+            throw std::runtime_error("error: transaction is not part of the workload stream");
+
+        current_first = block.first_tx;
+        current_size = block.offsets.size() - 1;
+        if (i - current_first < current_size)
+            return current_tx(i);
+    }
+}
+
+int WorkloadStream::waitReady()
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    cond.wait(lock, [this]() { return blocks[current].ready; });
+    return blocks[current].failed ? 1 : 0;
+}
+
+void WorkloadStream::prefetch()
+{
+    std::size_t r = 0;
+    std::size_t next_tx = ranges.empty() ? 0 : ranges[0].first_tx;
+    cursor = ranges.empty() ? tx_cursor_t{} : ranges[0].cursor;
+
+    for (std::size_t b = 0; ; b ^= 1) {
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            cond.wait(lock, [this, b]() { return stopped || !blocks[b].ready; });
+            if (stopped)
+                return;
+        }
+
+        // Blocks do not span ranges
+        while (r < ranges.size() && next_tx == ranges[r].last_tx && ++r < ranges.size()) {
+            next_tx = ranges[r].first_tx;
+            cursor = ranges[r].cursor;
+        }
+        last_tx = r < ranges.size() ? ranges[r].last_tx : next_tx;
+
+        // An empty block marks the end of the stream
+        auto& block = blocks[b];
+        block.first_tx = next_tx;
+        block.offsets.assign(1, 0);
+        block.cmds.clear();
+        block.failed = next_tx < last_tx && !fill(block, next_tx);
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            block.ready = true;
+        }
+        cond.notify_all();
+
+        if (block.failed || block.offsets.size() < 2)
+            return;
+        next_tx += block.offsets.size() - 1;
+    }
+}
+
+bool WorkloadStream::fill(Block& block, std::size_t first_tx)
+{
+    if (generator) {
+        generate(block, first_tx);
+        return true;
+    }
+
+    if (!(header.version == WORKLOAD_VERSION_PACKED ? readPacked(block, first_tx) : read(block, first_tx)))
+        return false;
+    for (const auto& cmd : block.cmds) {
+        if (cmd.opcode() > TX_OPCODE_MAX) {
+            std::cout << "error: invalid opcode " << static_cast<unsigned>(cmd.opcode()) << " in workload\n";
+            return false;
+        }
+        if (cmd.pos() >= num_pairs) {
+            std::cout << "error: position " << cmd.pos() << " is out of range in workload\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void WorkloadStream::generate(Block& block, std::size_t first_tx)
+{
+    // Take as many transactions as fit into the block, but at least one
+    for (auto i = first_tx; i < last_tx && (i == first_tx || block.cmds.size() < block_size); ++i) {
+        generator->generate(i, block.cmds, cursor);
+        block.offsets.push_back(block.cmds.size());
+    }
+}
+
+bool WorkloadStream::read(Block& block, std::size_t first_tx)
+{
+    const auto num_txs = std::min(last_tx - first_tx, block_size);
+    const off_t table_offset = sizeof(header) + first_tx * sizeof(std::uint64_t);
+    block.offsets.resize(num_txs + 1);
+    if (!readAll(fd, block.offsets.data(), block.offsets.size() * sizeof(std::uint64_t), table_offset))
+        return false;
+
+    // Take as many transactions as fit into the block, but at least one
+    const auto base = block.offsets[0];
+    std::size_t n = 0;
+    while (n < num_txs && (n == 0 || block.offsets[n + 1] - base <= block_size)) {
+        if (block.offsets[n + 1] < block.offsets[n] || block.offsets[n + 1] > header.num_cmds)
+            return false;
+        ++n;
+    }
+    block.offsets.resize(n + 1);
+    for (auto& offset : block.offsets)
+        offset -= base;
+
+    const off_t cmds_offset = sizeof(header)
+        + (header.num_txs + 1 + base) * sizeof(std::uint64_t);
+    block.cmds.resize(block.offsets.back());
+    return readAll(fd, block.cmds.data(), block.cmds.size() * sizeof(workload_cmd_t), cmds_offset);
+}
+
+bool WorkloadStream::readPacked(Block& block, std::size_t first_tx)
+{
+    const off_t blocks_offset = sizeof(header) + table.size() * sizeof(workload_block_entry_t);
+
+    // Decode whole packed blocks until the stream block is full, but at least one
+    auto b = first_tx / WORKLOAD_PACKED_BLOCK_TXS;
+    auto next_tx = b * WORKLOAD_PACKED_BLOCK_TXS;
+    while (next_tx < last_tx && block.cmds.size() < block_size) {
+        const auto& entry = table[b];
+        const auto& next = table[b + 1];
+        const auto num_txs = std::min(WORKLOAD_PACKED_BLOCK_TXS, header.num_txs - next_tx);
+        if (next.offset < entry.offset || next.first_cmd < entry.first_cmd)
+            return false;
+
+        packed.resize(next.offset - entry.offset);
+        if (!readAll(fd, packed.data(), packed.size(), blocks_offset + entry.offset))
+            return false;
+
+        const auto num_cmds = next.first_cmd - entry.first_cmd;
+        const auto base_tx = block.offsets.size();
+        const auto base_cmd = block.cmds.size();
+        block.offsets.resize(base_tx + num_txs);
+        block.cmds.resize(base_cmd + num_cmds);
+        if (!decodeWorkloadBlock(packed.data(), packed.size(), num_txs, num_cmds, base_cmd,
+                    block.offsets.data() + base_tx, block.cmds.data() + base_cmd))
+            return false;
+
+        ++b;
+        next_tx += num_txs;
+    }
+
+    // Drop the transactions of the first packed block preceding first_tx and
+    // those of the last one following last_tx
+    const auto skip = first_tx % WORKLOAD_PACKED_BLOCK_TXS;
+    if (skip) {
+        const auto first_cmd = block.offsets[skip];
+        block.cmds.erase(block.cmds.begin(), block.cmds.begin() + first_cmd);
+        block.offsets.erase(block.offsets.begin(), block.offsets.begin() + skip);
+        for (auto& offset : block.offsets)
+            offset -= first_cmd;
+    }
+    if (next_tx > last_tx) {
+        block.offsets.resize(block.offsets.size() - (next_tx - last_tx));
+        block.cmds.resize(block.offsets.back());
+    }
+    return true;
+}
+
+} // end namespace tools
+} // end namespace bench
@@ -2,105 +2,810 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+
+#include <sys/mman.h> // madvise
 
 #include "json/json.h"
 
 namespace bench {
 namespace tools {
 
-int parseWorkloadTransaction(const size_t index, const Json::Value& node, workload_t& workload);
+int parsePackedWorkload(const MappedFile& file, const workload_header_t& header, workload_t& workload);
 
-int readJSONFile(const std::string& filePath, Json::Value& root)
+int writeJSONFile(const std::string& filePath, const Json::Value& root)
 {
-    std::ifstream file(filePath, std::ifstream::binary);
+    std::ofstream file(filePath, std::ofstream::binary);
     if (!file.is_open()) {
         std::cout << "error: could not open file\n";
         return 1;
     }
-    file >> root;
+    file << root;
     return 0;
 }
 
-int writeJSONFile(const std::string& filePath, const Json::Value& root)
+bool isBinaryWorkload(const MappedFile& file)
 {
-    std::ofstream file(filePath, std::ofstream::binary);
+    return file.size() >= sizeof(workload_header_t)
+        && !std::memcmp(file.data(), WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC));
+}
+
+/**
+ * Checks if a file of file_size bytes can hold the workload described by
+ * header.
+ */
+int validateWorkloadHeader(const workload_header_t& header, std::uint64_t file_size)
+{
+    const std::uint64_t phases_size = header.num_phases * sizeof(std::uint64_t);
+    if (file_size - sizeof(header) < phases_size) {
+        std::cout << "error: workload is truncated\n";
+        return 1;
+    }
+    const auto payload_size = file_size - sizeof(header) - phases_size;
+
+    if (header.version == WORKLOAD_VERSION_PLAIN) {
+        const auto num_words = payload_size / sizeof(std::uint64_t);
+        if (num_words < header.num_txs + 1 || num_words - header.num_txs - 1 < header.num_cmds) {
+            std::cout << "error: workload is truncated\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (header.version == WORKLOAD_VERSION_PACKED) {
+        const auto num_entries = payload_size / sizeof(workload_block_entry_t);
+        if (num_entries < numWorkloadBlocks(header) + 1) {
+            std::cout << "error: workload is truncated\n";
+            return 1;
+        }
+        // Each transaction takes at least a byte for its length and each
+        // command at least a bit
+        const auto blocks_size = payload_size - (numWorkloadBlocks(header) + 1) * sizeof(workload_block_entry_t);
+        if (header.num_txs > blocks_size || header.num_cmds / 8 > blocks_size) {
+            std::cout << "error: workload is truncated\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    std::cout << "error: unsupported workload version " << header.version << "\n";
+    return 1;
+}
+
+/**
+ * Copies the phase table preceding file_end, the end of a binary workload,
+ * and validates it.
+ */
+int readPhaseTable(const char* file_end, const workload_header_t& header, std::vector<std::uint64_t>& starts)
+{
+    starts.resize(header.num_phases);
+    std::memcpy(starts.data(), file_end - starts.size() * sizeof(std::uint64_t),
+            starts.size() * sizeof(std::uint64_t));
+    if (!validPhaseStarts(starts, header.num_txs)) {
+        std::cout << "error: invalid phases in workload\n";
+        starts.clear();
+        return 1;
+    }
+    return 0;
+}
+
+int readWorkloadHeader(const std::string& filePath, workload_header_t& header)
+{
+    std::ifstream file(filePath, std::ifstream::binary | std::ifstream::ate);
     if (!file.is_open()) {
         std::cout << "error: could not open file\n";
         return 1;
     }
-    file << root;
+    const std::uint64_t file_size = file.tellg();
+    file.seekg(0);
+    if (file_size < sizeof(header)
+            || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC))) {
+        std::cout << "error: not a binary workload\n";
+        return 1;
+    }
+    return validateWorkloadHeader(header, file_size);
+}
+
+int readWorkloadPhases(const std::string& filePath, std::vector<std::uint64_t>& starts)
+{
+    workload_header_t header;
+    if (readWorkloadHeader(filePath, header))
+        return 1;
+
+    std::ifstream file(filePath, std::ifstream::binary | std::ifstream::ate);
+    std::vector<char> table(header.num_phases * sizeof(std::uint64_t));
+    file.seekg(-static_cast<std::streamoff>(table.size()), std::ifstream::end);
+    if (!file.read(table.data(), table.size())) {
+        std::cout << "error: could not read phases of workload\n";
+        return 1;
+    }
+    return readPhaseTable(table.data() + table.size(), header, starts);
+}
+
+int parseBinaryWorkload(const MappedFile& file, workload_t& workload)
+{
+    workload_header_t header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (validateWorkloadHeader(header, file.size()))
+        return 1;
+
+    std::vector<std::uint64_t> phases;
+    if (readPhaseTable(file.data() + file.size(), header, phases))
+        return 1;
+    if (header.version == WORKLOAD_VERSION_PACKED) {
+        if (parsePackedWorkload(file, header, workload))
+            return 1;
+        workload.setPhases(std::move(phases));
+        return 0;
+    }
+
+    // The file uses the in-memory layout, so both arrays are copied as is
+    const auto offsets = reinterpret_cast<const std::uint64_t*>(file.data() + sizeof(header));
+    const auto cmds = reinterpret_cast<const workload_cmd_t*>(offsets + header.num_txs + 1);
+    workload.offsets.assign(offsets, offsets + header.num_txs + 1);
+    workload.cmds.assign(cmds, cmds + header.num_cmds);
+
+    if (workload.offsets.front() != 0 || workload.offsets.back() != header.num_cmds
+            || !std::is_sorted(workload.offsets.begin(), workload.offsets.end())) {
+        std::cout << "error: invalid transaction offsets in workload\n";
+        workload.clear();
+        return 1;
+    }
+    for (const auto& cmd : workload.cmds) {
+        if (cmd.opcode() > TX_OPCODE_MAX) {
+            std::cout << "error: invalid opcode " << static_cast<unsigned>(cmd.opcode()) << " in workload\n";
+            workload.clear();
+            return 1;
+        }
+    }
+    workload.setPhases(std::move(phases));
     return 0;
 }
 
-int parseWorkload(const std::string& filePath, workload_t& workload)
+int writeBinaryWorkload(const std::string& filePath, const workload_t& work)
 {
-    Json::Value root;
-    if (readJSONFile(filePath, root))
+    std::ofstream file(filePath, std::ofstream::binary);
+    if (!file.is_open()) {
+        std::cout << "error: could not open file\n";
         return 1;
+    }
+
+    workload_header_t header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, WORKLOAD_MAGIC, sizeof(header.magic));
+    header.version = WORKLOAD_VERSION_PLAIN;
+    header.num_phases = work.phaseStarts().size();
+    header.num_txs = work.size();
+    header.num_cmds = work.numCmds();
+
+    const auto& offsets = work.txOffsets();
+    const auto& cmds = work.commands();
+    const auto& phases = work.phaseStarts();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+    file.write(reinterpret_cast<const char*>(cmds.data()), cmds.size() * sizeof(workload_cmd_t));
+    file.write(reinterpret_cast<const char*>(phases.data()), phases.size() * sizeof(std::uint64_t));
+
+    if (!file) {
+        std::cout << "error: could not write file\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ############################################################################
+// Packed format
+// ############################################################################
+
+// Widest bit-packed value that can be extracted with one unaligned 64-bit load
+constexpr unsigned WORKLOAD_PACKED_WIDTH_MAX = 57;
+
+std::uint64_t zigzag(std::int64_t v)
+{
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t v)
+{
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+unsigned bitWidth(std::uint64_t v)
+{
+    return v ? 64 - __builtin_clzll(v) : 0;
+}
+
+std::size_t varintSize(std::uint64_t v)
+{
+    return v < 0x80 ? 1 : (bitWidth(v) + 6) / 7;
+}
+
+void putVarint(std::string& out, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+bool getVarint(const unsigned char*& p, const unsigned char* end, std::uint64_t& v)
+{
+    // Most lengths and many deltas fit into a single byte
+    if (p < end && *p < 0x80) {
+        v = *p++;
+        return true;
+    }
+    v = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        const auto byte = *p++;
+        v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Encodes transactions [first_tx, last_tx) of work as a packed block (see
+ * decodeWorkloadBlock).
+ */
+void encodeWorkloadBlock(const workload_t& work, std::size_t first_tx, std::size_t last_tx, std::string& out)
+{
+    const auto& offsets = work.txOffsets();
+    const auto first = work.commands().data() + offsets[first_tx];
+    const auto last = work.commands().data() + offsets[last_tx];
+    const std::size_t num_cmds = last - first;
 
-    const auto work_size = root["size"].asInt();
-    workload.reserve(work_size);
-    workload.resize(work_size);
+    unsigned max_opcode = 0;
+    std::uint64_t max_pos = 0;
+    for (auto cmd = first; cmd != last; ++cmd) {
+        max_opcode = std::max(max_opcode, static_cast<unsigned>(cmd->opcode()));
+        max_pos = std::max(max_pos, cmd->pos());
+    }
+    const auto opcode_bits = bitWidth(max_opcode);
+    const auto pos_bits = bitWidth(max_pos);
+    const auto width = opcode_bits + pos_bits;
+
+    std::size_t delta_size = 0;
+    std::uint64_t prev = 0;
+    for (auto cmd = first; cmd != last; ++cmd) {
+        const auto delta = zigzag(static_cast<std::int64_t>(cmd->pos() - prev));
+        delta_size += varintSize(delta << opcode_bits | static_cast<unsigned>(cmd->opcode()));
+        prev = cmd->pos();
+    }
+    const auto packed_size = (num_cmds * width + 7) / 8 + sizeof(std::uint64_t);
+    // Commands take at least a bit, so that their number is bounded by the
+    // file size
+    const bool packed = width && width <= WORKLOAD_PACKED_WIDTH_MAX && packed_size <= delta_size;
 
-    const auto& txs = root["txs"];
-    for (unsigned i=0; i<txs.size(); ++i) {
-        if (parseWorkloadTransaction(i, txs[i], workload))
+    out.clear();
+    out.push_back(packed ? WORKLOAD_BLOCK_PACKED : WORKLOAD_BLOCK_DELTA);
+    out.push_back(opcode_bits);
+    out.push_back(pos_bits);
+    out.append(WORKLOAD_BLOCK_HEADER_SIZE - 3, '\0');
+    for (auto i = first_tx; i < last_tx; ++i)
+        putVarint(out, offsets[i + 1] - offsets[i]);
+
+    if (!packed) {
+        prev = 0;
+        for (auto cmd = first; cmd != last; ++cmd) {
+            const auto delta = zigzag(static_cast<std::int64_t>(cmd->pos() - prev));
+            putVarint(out, delta << opcode_bits | static_cast<unsigned>(cmd->opcode()));
+            prev = cmd->pos();
+        }
+        return;
+    }
+
+    // Values are packed starting at the least significant bit, the padding
+    // lets the decoder load 8 bytes at any value
+    const auto base = out.size();
+    out.resize(base + packed_size, '\0');
+    const auto dst = reinterpret_cast<unsigned char*>(&out[base]);
+    std::uint64_t bit = 0;
+    for (auto cmd = first; cmd != last; ++cmd, bit += width) {
+        const auto value = cmd->pos() << opcode_bits | static_cast<unsigned>(cmd->opcode());
+        std::uint64_t word;
+        std::memcpy(&word, dst + bit / 8, sizeof(word));
+        word |= value << (bit % 8);
+        std::memcpy(dst + bit / 8, &word, sizeof(word));
+    }
+}
+
+bool decodeWorkloadBlock(const char* data, std::size_t size, std::size_t num_txs,
+        std::size_t num_cmds, std::uint64_t first_cmd, std::uint64_t* offsets, workload_cmd_t* cmds)
+{
+    if (size < WORKLOAD_BLOCK_HEADER_SIZE)
+        return false;
+    auto p = reinterpret_cast<const unsigned char*>(data);
+    const auto end = p + size;
+    const unsigned encoding = p[0];
+    const unsigned opcode_bits = p[1];
+    const unsigned pos_bits = p[2];
+    if (opcode_bits > 8 || pos_bits > WORKLOAD_OPCODE_SHIFT)
+        return false;
+    p += WORKLOAD_BLOCK_HEADER_SIZE;
+
+    auto end_cmd = first_cmd;
+    for (std::size_t t = 0; t < num_txs; ++t) {
+        std::uint64_t length;
+        if (!getVarint(p, end, length))
+            return false;
+        end_cmd += length;
+        offsets[t] = end_cmd;
+    }
+    if (end_cmd - first_cmd != num_cmds)
+        return false;
+
+    const std::uint64_t opcode_mask = (1ULL << opcode_bits) - 1;
+    std::uint64_t max_opcode = 0;
+
+    if (encoding == WORKLOAD_BLOCK_PACKED) {
+        const auto width = opcode_bits + pos_bits;
+        if (!width || width > WORKLOAD_PACKED_WIDTH_MAX
+                || static_cast<std::size_t>(end - p) < (num_cmds * width + 7) / 8 + sizeof(std::uint64_t))
+            return false;
+
+        const std::uint64_t mask = (1ULL << width) - 1;
+        std::uint64_t bit = 0;
+        for (std::size_t i = 0; i < num_cmds; ++i, bit += width) {
+            std::uint64_t word;
+            std::memcpy(&word, p + bit / 8, sizeof(word));
+            const auto value = (word >> (bit % 8)) & mask;
+            const auto opcode = value & opcode_mask;
+            max_opcode = std::max(max_opcode, opcode);
+            cmds[i] = {static_cast<tx_opcode_t>(opcode), value >> opcode_bits};
+        }
+    }
+    else if (encoding == WORKLOAD_BLOCK_DELTA) {
+        std::uint64_t pos = 0;
+        for (std::size_t i = 0; i < num_cmds; ++i) {
+            std::uint64_t value;
+            if (!getVarint(p, end, value))
+                return false;
+            pos += unzigzag(value >> opcode_bits);
+            if (pos > WORKLOAD_POS_MASK)
+                return false;
+            const auto opcode = value & opcode_mask;
+            max_opcode = std::max(max_opcode, opcode);
+            cmds[i] = {static_cast<tx_opcode_t>(opcode), pos};
+        }
+    }
+    else {
+        return false;
+    }
+    return max_opcode <= static_cast<std::uint64_t>(TX_OPCODE_MAX);
+}
+
+int parsePackedWorkload(const MappedFile& file, const workload_header_t& header, workload_t& workload)
+{
+    const auto num_blocks = numWorkloadBlocks(header);
+    const auto table = reinterpret_cast<const workload_block_entry_t*>(file.data() + sizeof(header));
+    const auto blocks = reinterpret_cast<const char*>(table + num_blocks + 1);
+    const std::size_t blocks_size = file.data() + file.size()
+        - header.num_phases * sizeof(std::uint64_t) - blocks;
+
+    if (table[0].first_cmd != 0 || table[num_blocks].first_cmd != header.num_cmds) {
+        std::cout << "error: invalid block table in workload\n";
+        return 1;
+    }
+
+    workload.offsets.assign(header.num_txs + 1, 0);
+    workload.cmds.resize(header.num_cmds);
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+        const auto& entry = table[b];
+        const auto& next = table[b + 1];
+        const auto first_tx = b * WORKLOAD_PACKED_BLOCK_TXS;
+        const auto num_txs = std::min(WORKLOAD_PACKED_BLOCK_TXS, header.num_txs - first_tx);
+        if (next.offset < entry.offset || next.offset > blocks_size
+                || next.first_cmd < entry.first_cmd || next.first_cmd > header.num_cmds
+                || !decodeWorkloadBlock(blocks + entry.offset, next.offset - entry.offset,
+                        num_txs, next.first_cmd - entry.first_cmd, entry.first_cmd,
+                        workload.offsets.data() + first_tx + 1, workload.cmds.data() + entry.first_cmd)) {
+            std::cout << "error: invalid block " << b << " in workload\n";
+            workload.clear();
             return 1;
+        }
     }
     return 0;
 }
 
-int parseWorkloadTransaction(const size_t index, const Json::Value& tx_node, workload_t& workload)
+int writePackedWorkload(const std::string& filePath, const workload_t& work)
 {
-    // Get i-th preallocated transaction
-    auto& tx = workload[index];
+    std::ofstream file(filePath, std::ofstream::binary);
+    if (!file.is_open()) {
+        std::cout << "error: could not open file\n";
+        return 1;
+    }
+
+    workload_header_t header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, WORKLOAD_MAGIC, sizeof(header.magic));
+    header.version = WORKLOAD_VERSION_PACKED;
+    header.num_phases = work.phaseStarts().size();
+    header.num_txs = work.size();
+    header.num_cmds = work.numCmds();
+
+    // The block table precedes the blocks, so all blocks are encoded first
+    const auto num_blocks = numWorkloadBlocks(header);
+    std::vector<workload_block_entry_t> table(num_blocks + 1);
+    std::string blocks;
+    std::string block;
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+        const auto first_tx = b * WORKLOAD_PACKED_BLOCK_TXS;
+        const auto last_tx = std::min(first_tx + WORKLOAD_PACKED_BLOCK_TXS, work.size());
+        table[b] = {blocks.size(), work.txOffsets()[first_tx]};
+        encodeWorkloadBlock(work, first_tx, last_tx, block);
+        blocks += block;
+    }
+    table[num_blocks] = {blocks.size(), work.numCmds()};
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(workload_block_entry_t));
+    file.write(blocks.data(), blocks.size());
+    file.write(reinterpret_cast<const char*>(work.phaseStarts().data()),
+            work.phaseStarts().size() * sizeof(std::uint64_t));
 
-    // Preallocate commands for this transactions
-    const auto tx_size = tx_node["size"].asUInt64();
-    tx.reserve(tx_size);
-    tx.resize(tx_size);
+    if (!file) {
+        std::cout << "error: could not write file\n";
+        return 1;
+    }
+    return 0;
+}
 
-    // Init preallocated commands for this transaction
-    const auto& tx_cmds = tx_node["cmds"];
-    for (unsigned i=0; i<tx_cmds.size(); ++i) {
-        const auto& cmd_node = tx_cmds[i];
+// ############################################################################
+// JSON format
+// ############################################################################
 
-        // Get target position in sample data set
-        const auto pos = cmd_node["pos"].asInt();
-        tx[i].pos = pos;
+/**
+ * Pull parser for JSON workloads.
+ *
+ * Commands are appended to the workload while the document is read, so no
+ * document tree is ever built. Members may appear in any order, unknown
+ * members are skipped. Positions are read as unsigned 64-bit integers and
+ * must be less than num_pairs.
+ */
+class JsonWorkloadParser
+{
+public:
+    JsonWorkloadParser(const char* begin, const char* end, std::uint64_t num_pairs, workload_t& workload)
+        : begin{begin}
+        , p{begin}
+        , end{end}
+        , num_pairs{num_pairs}
+        , workload{workload}
+    {}
 
-        // Get operation to perform
-        const auto cmd = cmd_node["cmd"].asString();
-        if (cmd == "get") {
-            tx[i].opcode = tx_opcode_t::Get;
+    int parse()
+    {
+        workload.clear();
+        if (!parseRoot()) {
+            const auto line = 1 + std::count(begin, std::min(p, end), '\n');
+            std::cout << "error: " << error << " in line " << line << " of workload\n";
+            workload.clear();
+            return 1;
         }
-        else if (cmd == "put") {
-            tx[i].opcode = tx_opcode_t::Put;
+        return 0;
+    }
+
+private:
+    bool fail(const char* message)
+    {
+        if (error.empty())
+            error = message;
+        return false;
+    }
+
+    void skipSpace()
+    {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r'))
+            ++p;
+    }
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (p < end && *p == c) {
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Reads a string without resolving escape sequences.
+     */
+    bool parseString(std::string_view& str)
+    {
+        if (!consume('"'))
+            return fail("expected string");
+        const auto first = p;
+        while (p < end && *p != '"')
+            p += *p == '\\' ? 2 : 1;
+        if (p >= end)
+            return fail("unterminated string");
+        str = {first, static_cast<std::size_t>(p - first)};
+        ++p;
+        return true;
+    }
+
+    bool parseUint(std::uint64_t& value)
+    {
+        skipSpace();
+        if (p >= end || *p < '0' || *p > '9')
+            return fail("expected unsigned integer");
+        value = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            const unsigned digit = *p - '0';
+            if (value > (UINT64_MAX - digit) / 10)
+                return fail("integer out of range");
+            value = value * 10 + digit;
+        }
+        if (p < end && (*p == '.' || *p == 'e' || *p == 'E'))
+            return fail("expected unsigned integer");
+        return true;
+    }
+
+    bool skipValue(unsigned depth = 0)
+    {
+        if (depth > JSON_DEPTH_MAX)
+            return fail("document nested too deeply");
+        skipSpace();
+        if (p >= end)
+            return fail("unexpected end of document");
+
+        if (*p == '"') {
+            std::string_view str;
+            return parseString(str);
+        }
+        if (*p == '{' || *p == '[') {
+            const char close = *p == '{' ? '}' : ']';
+            const bool object = *p++ == '{';
+            if (consume(close))
+                return true;
+            do {
+                if (object) {
+                    std::string_view name;
+                    if (!parseString(name) || !consume(':'))
+                        return fail("expected member");
+                }
+                if (!skipValue(depth + 1))
+                    return false;
+            } while (consume(','));
+            return consume(close) || fail("expected , or closing bracket");
+        }
+
+        // Numbers, true, false and null
+        const auto first = p;
+        while (p < end && *p != ',' && *p != '}' && *p != ']'
+                && *p != ' ' && *p != '\n' && *p != '\t' && *p != '\r')
+            ++p;
+        return p != first || fail("expected value");
+    }
+
+    /**
+     * Parses an object, calling member(name) for each member. member must
+     * consume the value.
+     */
+    template<typename Member>
+    bool parseObject(Member member)
+    {
+        if (!consume('{'))
+            return fail("expected object");
+        if (consume('}'))
+            return true;
+        do {
+            std::string_view name;
+            if (!parseString(name))
+                return false;
+            if (!consume(':'))
+                return fail("expected :");
+            if (!member(name))
+                return false;
+        } while (consume(','));
+        return consume('}') || fail("expected , or }");
+    }
+
+    bool consumeNull()
+    {
+        skipSpace();
+        if (end - p >= 4 && std::string_view{p, 4} == "null") {
+            p += 4;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Parses an array, calling element() for each element. null counts as
+     * an empty array, which older versions wrote for empty transactions.
+     */
+    template<typename Element>
+    bool parseArray(Element element)
+    {
+        if (consumeNull())
+            return true;
+        if (!consume('['))
+            return fail("expected array");
+        if (consume(']'))
+            return true;
+        do {
+            if (!element())
+                return false;
+        } while (consume(','));
+        return consume(']') || fail("expected , or ]");
+    }
+
+    bool parseRoot()
+    {
+        const bool ok = parseObject([this](std::string_view name) {
+            if (name == "size") {
+                std::uint64_t num_txs;
+                if (!parseUint(num_txs))
+                    return false;
+                workload.reserve(num_txs, 0);
+                return true;
+            }
+            if (name == "txs")
+                return parseArray([this]() { return parseTransaction(); });
+            if (name == "phases") {
+                return parseArray([this]() {
+                    std::uint64_t start;
+                    if (!parseUint(start))
+                        return false;
+                    phases.push_back(start);
+                    return true;
+                });
+            }
+            return skipValue();
+        });
+        skipSpace();
+        if (!ok || (p != end && !fail("unexpected data after document")))
+            return false;
+        if (!validPhaseStarts(phases, workload.size()))
+            return fail("invalid phases");
+        workload.setPhases(std::move(phases));
+        return true;
+    }
+
+    bool parseTransaction()
+    {
+        const bool ok = parseObject([this](std::string_view name) {
+            if (name == "cmds")
+                return parseArray([this]() { return parseCommand(); });
+            return skipValue();
+        });
+        workload.finishTx();
+        return ok;
+    }
+
+    bool parseCommand()
+    {
+        bool has_opcode = false;
+        bool has_pos = false;
+        tx_opcode_t opcode;
+        std::uint64_t pos;
+        const bool ok = parseObject([&](std::string_view name) {
+            if (name == "cmd") {
+                std::string_view cmd;
+                if (!parseString(cmd))
+                    return false;
+                if (cmd == "get")
+                    opcode = tx_opcode_t::Get;
+                else if (cmd == "put")
+                    opcode = tx_opcode_t::Put;
+                else if (cmd == "ins")
+                    opcode = tx_opcode_t::Ins;
+                else if (cmd == "del")
+                    opcode = tx_opcode_t::Del;
+                else if (cmd == "rmw")
+                    opcode = tx_opcode_t::Rmw;
+                else
+                    return fail("unknown command");
+                has_opcode = true;
+                return true;
+            }
+            if (name == "pos") {
+                if (!parseUint(pos))
+                    return false;
+                if (pos >= num_pairs || pos > WORKLOAD_POS_MASK)
+                    return fail("position out of range");
+                has_pos = true;
+                return true;
+            }
+            return skipValue();
+        });
+        if (!ok)
+            return false;
+        if (!has_opcode || !has_pos)
+            return fail("command lacks cmd or pos");
+        workload.appendCmd({opcode, pos});
+        return true;
+    }
+
+    static constexpr unsigned JSON_DEPTH_MAX = 64;
+
+    const char* begin;
+    const char* p;
+    const char* end;
+    std::uint64_t num_pairs;
+    workload_t& workload;
+    std::vector<std::uint64_t> phases;
+    std::string error;
+};
+
+// ############################################################################
+// Workload
+// ############################################################################
+
+int parseWorkload(const std::string& filePath, workload_t& workload, std::uint64_t num_pairs)
+{
+    MappedFile file;
+    if (file.open(filePath)) {
+        std::cout << "error: could not open file\n";
+        return 1;
+    }
+
+    if (!isBinaryWorkload(file)) {
+        // The document is read front to back exactly once
+        ::madvise(const_cast<char*>(file.data()), file.size(), MADV_SEQUENTIAL);
+        return JsonWorkloadParser{file.data(), file.data() + file.size(), num_pairs, workload}.parse();
+    }
+
+    if (parseBinaryWorkload(file, workload))
+        return 1;
+    for (const auto& cmd : workload.commands()) {
+        if (cmd.pos() >= num_pairs) {
+            std::cout << "error: position " << cmd.pos() << " is out of range in workload\n";
+            workload.clear();
+            return 1;
         }
-        // std::cout << "cmd: " << cmd << ", pos: " << pos << std::endl;
     }
-    // std::printf("\n");
     return 0;
 }
 
-int writeWorkload(const std::string& filePath, const workload_t& work)
+int writeWorkload(const std::string& filePath, const workload_t& work, workload_format_t format)
 {
+    if (format == workload_format_t::Bin)
+        return writeBinaryWorkload(filePath, work);
+    if (format == workload_format_t::Packed)
+        return writePackedWorkload(filePath, work);
+
     Json::Value root;
     root["size"] = static_cast<Json::UInt64>(work.size());
-    auto& txs_node = root["txs"];
-    for (const auto& tx : work) {
+    if (!work.phaseStarts().empty()) {
+        auto& phases_node = root["phases"];
+        for (const auto start : work.phaseStarts())
+            phases_node.append(static_cast<Json::UInt64>(start));
+    }
+    // Empty arrays must not be written as null
+    auto& txs_node = root["txs"] = Json::arrayValue;
+    for (std::size_t i = 0; i < work.size(); ++i) {
+        const auto tx = work[i];
         Json::Value tx_node;
         tx_node["size"] = static_cast<Json::UInt64>(tx.size());
-        auto& cmds_node = tx_node["cmds"];
-        for (const auto& [cmd, pos] : tx) {
+        auto& cmds_node = tx_node["cmds"] = Json::arrayValue;
+        for (const auto& cmd : tx) {
             Json::Value cmd_node;
-            if (cmd == tx_opcode_t::Get) {
+            if (cmd.opcode() == tx_opcode_t::Get) {
                 cmd_node["cmd"] = "get";
             }
-            else if (cmd == tx_opcode_t::Put) {
+            else if (cmd.opcode() == tx_opcode_t::Put) {
                 cmd_node["cmd"] = "put";
             }
-            cmd_node["pos"] = static_cast<Json::UInt64>(pos);
+            else if (cmd.opcode() == tx_opcode_t::Ins) {
+                cmd_node["cmd"] = "ins";
+            }
+            else if (cmd.opcode() == tx_opcode_t::Del) {
+                cmd_node["cmd"] = "del";
+            }
+            else if (cmd.opcode() == tx_opcode_t::Rmw) {
+                cmd_node["cmd"] = "rmw";
+            }
+            cmd_node["pos"] = static_cast<Json::UInt64>(cmd.pos());
             cmds_node.append(cmd_node);
         }
         txs_node.append(tx_node);